@@ -0,0 +1,231 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+
+/* bench.c
+ * -------
+ * nsuds --benchmark: play a scripted game without a terminal. Curses is
+ * started on a screen that writes to a temporary file and reads keys
+ * from another, which holds the script, so the real input loops, menus,
+ * scrollers and drawing code are all run. When the script runs out, the
+ * grid on the screen is checked against the board, and the time taken
+ * and bytes written are printed.
+ * The timer is stopped, so the output is the same on every run.
+ * --benchmark-help pages through the help instead, on a wide screen,
+ * to measure drawing a full scroller. The grid isn't checked then. */
+#include "config.h"
+
+#define _XOPEN_SOURCE 500
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#if STDC_HEADERS || HAVE_STRING_H
+   #include <string.h>
+#else /* Old system with only <strings.h> */
+   #include <strings.h>
+#endif
+#ifdef HAVE_NCURSES_H
+   #include <ncurses.h>
+#else
+   #include <curses.h>
+#endif
+
+#include "nsuds.h"
+#include "board.h"
+#include "frame.h"
+#include "timer.h"
+#include "bench.h"
+#include "util.h"
+
+static int running=0;
+static FILE *out;          /* Where curses writes to */
+static int nkeys;          /* Keys in the script */
+static int help_only;      /* Benchmarking the help, not the game */
+static struct timeval started;
+
+static char *make_script(int rounds, int *len);
+static char *help_script(int rounds, int *len);
+static int check_screen(void);
+
+/* Set up a screen for a benchmark of the given number of rounds, of
+ * the game or of the help. Must be called before curses is started.
+ * Returns 0 on failure. */
+int bench_start(int rounds, int help)
+{
+   static char lines[16], cols[16]; /* putenv() keeps these */
+   int len;
+   char *script;
+   FILE *in;
+   SCREEN *scr;
+
+   script = help ? help_script(rounds, &len) : make_script(rounds, &len);
+   in = tmpfile();
+   out = tmpfile();
+   if (in == NULL || out == NULL) return 0;
+   if (fwrite(script, 1, len, in) != (size_t)len || fflush(in)) return 0;
+   free(script);
+   nkeys = len;
+
+   /* Keys come from stdin, so poll() for typeahead sees them */
+   if (dup2(fileno(in), STDIN_FILENO) == -1) return 0;
+   fclose(in);
+   rewind(stdin);
+
+   sprintf(lines, "LINES=%d", help ? BENCH_HELP_LINES : BENCH_LINES);
+   sprintf(cols, "COLUMNS=%d", help ? BENCH_HELP_COLS : BENCH_COLS);
+   putenv(lines);
+   putenv(cols);
+   scr = newterm("xterm", out, stdin);
+   if (scr == NULL) return 0;
+   set_term(scr);
+
+   /* No timer ticks, so every run draws the same */
+   timer_freeze();
+   /* Draw after every key, like someone typing */
+   frame_coalesce(0);
+
+   help_only=help;
+   running=1;
+   gettimeofday(&started, NULL);
+   return 1;
+}
+
+/* Is a benchmark being run? */
+int bench_running(void)
+{
+   return running;
+}
+
+/* The script has run out: check the screen (unless it was the help
+ * being benchmarked), report and exit */
+void bench_finish(void)
+{
+   struct timeval now;
+   struct stat st;
+   double secs;
+   int bad;
+
+   gettimeofday(&now, NULL);
+   secs = (now.tv_sec - started.tv_sec)
+      + (now.tv_usec - started.tv_usec) / 1e6;
+   bad = help_only ? 0 : check_screen();
+   endwin();
+   fflush(out);
+   fstat(fileno(out), &st);
+
+   printf("nsuds benchmark: %d keys, %ld frames in %.3f seconds\n",
+      nkeys, frame_count, secs);
+   printf("  %.1f us per key\n", secs * 1e6 / nkeys);
+   printf("  %ld bytes written, %.1f per key\n", (long)st.st_size,
+      (double)st.st_size / nkeys);
+   if (bad) {
+      printf("  screen check FAILED: %d squares differ from the board\n",
+         bad);
+      exit(EXIT_FAILURE);
+   }
+   if (!help_only) printf("  screen check ok\n");
+   exit(EXIT_SUCCESS);
+}
+
+/* Add a key to the script */
+#define key(c) (script[(*len)++] = (c))
+
+/* Build the keys to play. Each round fills every square with 1
+ * (which can never be a solution, so the game isn't won) and marks
+ * it, highlights and clears marks, pauses, opens the help, tries a
+ * guess and rolls it back, then empties the grid again. */
+static char *make_script(int rounds, int *len)
+{
+   char *script = tmalloc(rounds * 700 + 16);
+   int r, y, x;
+
+   *len=0;
+   key('\n'); /* Choose Easy */
+   for (r=0; r<rounds; r++) {
+      /* Snake through the grid, filling and marking */
+      for (y=0; y<9; y++) {
+         for (x=0; x<9; x++) {
+            key('1');
+            key('m'); key('0' + 1 + (x + y) % 9);
+            if (x < 8) key(y % 2 ? 'h' : 'l');
+         }
+         if (y < 8) key('j');
+      }
+      key('r'); key('5');
+      key('R'); key('2'); key('3'); key('4');
+      key('C'); key('3');
+      key('r'); key('\n');
+      key('p'); key('p');
+      key('?'); key('j'); key('j'); key('q');
+      key('t');
+      for (x=0; x<8; x++) { key('x'); key('k'); }
+      key('u');
+      /* And back up again, emptying every square */
+      for (y=8; y>=0; y--) {
+         for (x=0; x<9; x++) {
+            key('x');
+            key('c'); key('0' + 1 + (x + y) % 9);
+            if (x < 8) key((8 - y) % 2 ? 'h' : 'l');
+         }
+         if (y > 0) key('k');
+      }
+      /* Back to the top left */
+      for (x=0; x<8; x++) key('h');
+   }
+   return script;
+}
+
+/* Open the help, and page down through it and back to the top
+ * each round. Every key redraws the whole scroller. */
+static char *help_script(int rounds, int *len)
+{
+   char *script = tmalloc(rounds * (BENCH_HELP_PAGES + 1) + 16);
+   int r, i;
+
+   *len=0;
+   key('\n'); /* Choose Easy */
+   key('?');
+   for (r=0; r<rounds; r++) {
+      for (i=0; i<BENCH_HELP_PAGES; i++) key(CTRL('d'));
+      key('g');
+   }
+   key('q');
+   return script;
+}
+#undef key
+
+/* Compare the grid on the screen with the board.
+ * Returns the number of squares that differ. */
+static int check_screen(void)
+{
+   int y, x, bad=0;
+   chtype want, got;
+
+   for (y=0; y<9; y++) {
+      for (x=0; x<9; x++) {
+         want = board.st.cells[y][x] ? '0' + board.st.cells[y][x] : ' ';
+         got = mvwinch(curscr, 3 + y * 2, 30 + x * 4) & A_CHARTEXT;
+         if (got != want) bad++;
+      }
+   }
+   return bad;
+}
@@ -0,0 +1,37 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+#ifndef _NSUDS_BENCH_H
+#define _NSUDS_BENCH_H
+
+/* Rounds of scripted play in a benchmark, if not given */
+#define BENCH_ROUNDS 20
+/* Size of the benchmark's screen */
+#define BENCH_LINES 30
+#define BENCH_COLS 100
+/* and of --benchmark-help's, which pages through the help */
+#define BENCH_HELP_LINES 60
+#define BENCH_HELP_COLS 200
+#define BENCH_HELP_PAGES 20 /* Half pages down in each round */
+
+extern int bench_start(int rounds, int help);
+extern int bench_running(void);
+extern void bench_finish(void);
+
+#endif
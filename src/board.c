@@ -0,0 +1,269 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+
+/* board.c
+ * -------
+ * The rules side of the grid: filling in squares, pencil marks and
+ * checking the solution. Drawing lives in grid.c
+ *
+ * Each board keeps a Zobrist hash of its cells, updated with an XOR on
+ * every change. Validity and the number of solutions are cached by the
+ * hash, so asking again about the same position (even after a roll back)
+ * doesn't recompute anything. Pencil marks aren't hashed: nothing that's
+ * cached depends on them, so they'd only split one position's entries. */
+#include "config.h"
+
+#ifdef HAVE_NCURSES_H
+   #include <ncurses.h>
+#else 
+   #include <curses.h>
+#endif
+
+#if STDC_HEADERS || HAVE_STRING_H
+   #include <string.h>
+#else /* Old system with only <strings.h> */
+   #include <strings.h>
+#endif
+
+#include "board.h"
+#include "gen.h"
+
+/* Random keys for each number in each square */
+static uint64_t zcell[9][9][10];
+static int zinit=0;
+
+/* Cached results, indexed by the low bits of the cell hash */
+static struct {
+   uint64_t key;           /* Cell hash these results are for */
+   signed char valid;      /* board_valid(), or -1 if not known yet */
+   signed char solutions;  /* board_solutions(), or -1 if not known yet */
+} cache[BOARD_CACHE];
+
+static void zobrist_init(void);
+static int check_valid(struct board *b);
+
+/* Fill the key tables, using splitmix64 with a fixed seed so
+ * hashes don't depend on rand() (which the generator reseeds) */
+static void zobrist_init(void)
+{
+   uint64_t s = ((uint64_t)0x9e3779b9UL << 32) | 0x7f4a7c15UL;
+   uint64_t z;
+   int i, j, n;
+
+   for (i=0; i<9; i++) {
+      for (j=0; j<9; j++) {
+         for (n=0; n<10; n++) {
+            s += ((uint64_t)0x9e3779b9UL << 32) | 0x7f4a7c15UL;
+            z = s;
+            z = (z ^ (z >> 30)) * (((uint64_t)0xbf58476dUL << 32) | 0x1ce4e5b9UL);
+            z = (z ^ (z >> 27)) * (((uint64_t)0x94d049bbUL << 32) | 0x133111ebUL);
+            z ^= z >> 31;
+            zcell[i][j][n] = z;
+         }
+         /* Empty squares don't change the hash */
+         zcell[i][j][0] = 0;
+      }
+   }
+   memset(cache, 0, sizeof(cache));
+   for (i=0; i<BOARD_CACHE; i++) cache[i].valid = cache[i].solutions = -1;
+   zinit=1;
+}
+
+/* Work out the hash from scratch, after the board has been
+ * changed other than through the functions below */
+void board_rehash(struct board *b)
+{
+   int i, j;
+
+   if (!zinit) zobrist_init();
+   b->st.hash = 0;
+   for (i=0; i<9; i++)
+      for (j=0; j<9; j++)
+         b->st.hash ^= zcell[i][j][(int)b->st.cells[i][j]];
+}
+
+/* Start the board on a new puzzle. Squares in puzzle are -n for a given
+ * n, n for a number the user put in, and 0 if empty. Marks and
+ * highlighting are reset. */
+void board_load(struct board *b, char puzzle[9][9])
+{
+   int i, j;
+
+   memset(b->givens, 0, sizeof(b->givens));
+   memset(b->st.marks, 0, sizeof(b->st.marks));
+   memset(b->showmarks, 0, sizeof(b->showmarks));
+   b->st.filled = 0;
+   b->ntries = 0;
+   for (i=0; i<9; i++) {
+      for (j=0; j<9; j++) {
+         if (puzzle[i][j] < 0) b->givens[i] |= 1 << j;
+         b->st.cells[i][j] = puzzle[i][j] < 0 ? -puzzle[i][j] : puzzle[i][j];
+         if (b->st.cells[i][j]) b->st.filled++;
+      }
+   }
+   board_rehash(b);
+   board_touch_all(b);
+}
+
+/* Every square needs repainting, e.g. after the grid
+ * window has been cleared */
+void board_touch_all(struct board *b)
+{
+   int i;
+   for (i=0; i<9; i++) b->dirty[i] = 0x1ff;
+}
+
+/* Fill in (or with 0, empty) a square. Returns 0 if the
+ * square is part of the puzzle and can't be changed. */
+int board_set(struct board *b, int y, int x, int val)
+{
+   if (board_given(b, y, x)) return 0;
+
+   if (b->st.cells[y][x] && !val) b->st.filled--;
+   else if (!b->st.cells[y][x] && val) b->st.filled++;
+   b->st.hash ^= zcell[y][x][(int)b->st.cells[y][x]] ^ zcell[y][x][val];
+   b->st.cells[y][x] = val;
+   board_touch(b, y, x);
+   return 1;
+}
+
+/* Set or clear a pencil mark */
+void board_mark(struct board *b, int y, int x, int num, int set)
+{
+   if (set) b->st.marks[y][x] |= MARK(num);
+   else b->st.marks[y][x] &= ~MARK(num);
+   board_touch(b, y, x);
+}
+
+/* Clear every mark for a number */
+void board_clear_marks(struct board *b, int num)
+{
+   int i, j;
+   for (i=0; i<9; i++) {
+      for (j=0; j<9; j++) {
+         if (b->st.marks[i][j] & MARK(num)) board_touch(b, i, j);
+         b->st.marks[i][j] &= ~MARK(num);
+      }
+   }
+}
+
+/* Start a try: snapshot the board so it can be rolled back
+ * to this point. Returns the new try depth, or 0 if tries
+ * are already nested as deep as they go. */
+int board_try(struct board *b)
+{
+   if (b->ntries >= BOARD_TRIES) return 0;
+   memcpy(&b->tries[b->ntries], &b->st, sizeof(b->st));
+   return ++b->ntries;
+}
+
+/* Abandon try number depth (1 is the outermost) and every
+ * try nested inside it, putting the board back how it was
+ * when that try started. */
+void board_rollback(struct board *b, int depth)
+{
+   if (depth < 1 || depth > b->ntries) return;
+   memcpy(&b->st, &b->tries[depth-1], sizeof(b->st));
+   b->ntries = depth-1;
+   board_touch_all(b);
+}
+
+/* Accept try number depth and every try nested inside it,
+ * keeping the board as it is now. */
+void board_commit(struct board *b, int depth)
+{
+   if (depth < 1 || depth > b->ntries) return;
+   b->ntries = depth-1;
+}
+
+/* Check if a full or partially filled
+ * sudoku grid is valid or not */
+int board_valid(struct board *b)
+{
+   int i = b->st.hash % BOARD_CACHE;
+
+   if (cache[i].key != b->st.hash) {
+      cache[i].key = b->st.hash;
+      cache[i].valid = cache[i].solutions = -1;
+   }
+   if (cache[i].valid == -1) cache[i].valid = check_valid(b);
+   return cache[i].valid;
+}
+
+/* How many ways can the grid be finished? 0 means there's a
+ * mistake somewhere, 2 means 2 or more. */
+int board_solutions(struct board *b)
+{
+   int i = b->st.hash % BOARD_CACHE;
+
+   if (cache[i].key != b->st.hash) {
+      cache[i].key = b->st.hash;
+      cache[i].valid = cache[i].solutions = -1;
+   }
+   if (cache[i].solutions == -1)
+      cache[i].solutions = count_solutions(b->st.cells);
+   return cache[i].solutions;
+}
+
+/* Check the rows, columns and segments for repeats */
+static int check_valid(struct board *b)
+{
+   int i,j,k;
+   char rowf[9], colf[9];
+
+   /* Check rows/cols */
+   for (i=0; i<9; i++) {
+      /* Reset row/col finds */
+      memset(&rowf, 0, 9);
+      memset(&colf, 0, 9);
+
+      /* Add finds to colf/rowf */
+      for (j=0; j<9; j++) {
+         if (b->st.cells[i][j]) colf[b->st.cells[i][j]-1]++;
+         if (b->st.cells[j][i]) rowf[b->st.cells[j][i]-1]++;
+      }
+      
+      /* Check if a number was found more than once per
+       * row/col */
+      for (j=0; j<9; j++) {
+         if (colf[j] > 1 || rowf[j] > 1) return 0;
+      }
+   }
+
+   /* Check segments (segment start=(i,j)) */
+   for (i=0; i<9; i+=3) {
+      for (j=0; j<9; j+=3) {
+         memset(&rowf, 0, 9);
+         
+         /* Check #'s within each segment */
+         for (k=0;k<3;k++) {
+            if (b->st.cells[i+k][j])   rowf[b->st.cells[i+k][j]-1]++;
+            if (b->st.cells[i+k][j+1]) rowf[b->st.cells[i+k][j+1]-1]++;
+            if (b->st.cells[i+k][j+2]) rowf[b->st.cells[i+k][j+2]-1]++;
+         }
+
+         for (k=0; k<9; k++) {
+            if (rowf[k] > 1) return 0;
+         }
+      }
+   }
+
+   return 1;
+}
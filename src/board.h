@@ -0,0 +1,73 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+#ifndef _NSUDS_BOARD_H
+#define _NSUDS_BOARD_H
+#include <stdint.h>
+
+/* Deepest a player can nest tries */
+#define BOARD_TRIES 8
+
+/* The part of a board that changes as it's played. It's a few hundred
+ * bytes with no pointers, so a copy of it is a complete snapshot. */
+struct board_state {
+   char cells[9][9];           /* cells[y/row][x/col], 0 if empty */
+   unsigned short marks[9][9]; /* Pencil marks, bit n set if n is marked */
+   int filled;                 /* Number of squares filled in */
+   uint64_t hash;              /* Zobrist hash of cells */
+};
+
+/* Everything about the puzzle being played. Nothing here touches
+ * the screen except through win, which may be NULL to play a
+ * board without drawing it (e.g. for benchmarks). */
+struct board {
+   struct board_state st;      /* Current contents */
+   unsigned short givens[9];   /* Bit x of givens[y] set if (y,x) is given */
+   unsigned short dirty[9];    /* Bit x of dirty[y] set if (y,x) needs
+                                  repainting */
+   short showmarks[3];         /* Marks being highlighted */
+   int curx, cury;             /* Current (selected) square */
+   WINDOW *win;                /* Window the grid is drawn in */
+   struct board_state tries[BOARD_TRIES]; /* Snapshot before each try */
+   int ntries;                 /* Number of tries in progress */
+};
+
+/* Entries in the cache of results for board positions */
+#define BOARD_CACHE 64
+
+/* Candidate bit for a mark */
+#define MARK(n) (1 << (n))
+/* Is a square part of the original puzzle? */
+#define board_given(b, y, x) ((b)->givens[y] & (1 << (x)))
+/* Mark a square as needing to be repainted */
+#define board_touch(b, y, x) ((b)->dirty[y] |= 1 << (x))
+
+extern void board_load(struct board *b, char puzzle[9][9]);
+extern int board_set(struct board *b, int y, int x, int val);
+extern void board_mark(struct board *b, int y, int x, int num, int set);
+extern void board_clear_marks(struct board *b, int num);
+extern void board_touch_all(struct board *b);
+extern void board_rehash(struct board *b);
+extern int board_valid(struct board *b);
+extern int board_solutions(struct board *b);
+extern int board_try(struct board *b);
+extern void board_rollback(struct board *b, int depth);
+extern void board_commit(struct board *b, int depth);
+
+#endif
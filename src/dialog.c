@@ -31,8 +31,10 @@
 
 #include "dialog.h"
 #include "nsuds.h"
+#include "board.h"
 #include "timer.h"
 #include "util.h"
+#include "frame.h"
 
 /* Launch a dialog that asks OK/Cancel for a question,
  * pausing the game while it waits for input */
@@ -40,16 +42,15 @@ bool confirm(char *question)
 {
    int c;
    bool status=true;
-   WINDOW *confirm;
+   static WINDOW *confirm; /* Kept for next time */
 
-   /* Cancel alarm */
-   alarm(0);
    game_pause(1);
    /* Only redraw the grid if the help isn't open */
-   if (!scrl_open) draw_grid();
+   if (!scrl_open) draw_grid(&board);
 
 redraw:
-   confirm = newwin(row * 0.4, col * 0.7, row * 0.3, col * 0.15);
+   confirm = place_window(confirm, row * 0.4, col * 0.7, row * 0.3, col * 0.15);
+   werase(confirm);
 
    /* Draw dialog */
    wbkgd(confirm, COLOR_PAIR(C_DIALOG));
@@ -66,7 +67,6 @@ redraw:
    while ((c = getkey())) {
       switch (c) {
          case KEY_RESIZE:
-            getmaxyx(stdscr, row, col);
             draw_all();
             goto redraw;
          case KEY_LEFT:
@@ -88,16 +88,14 @@ redraw:
                mvwaddstr(confirm, (row * 0.4) -3, col *0.35 - 9, "   OK   ");
             }
             status = !status;
-            wrefresh(confirm);
+            frame_refresh(confirm);
             break;				
          /* Enter pressed */
          case 10:
             werase(confirm);
-            delwin(confirm);
             if (!scrl_open) {
                game_pause(0);
             }
-            catch_alarm(0);
             fbar_time=0;
             return status;
          default:
@@ -111,20 +109,19 @@ redraw:
 char *getstring(char *question)
 {
    int c, width, apos=0;
-   WINDOW *dialog;
+   static WINDOW *dialog; /* Kept for next time */
    char *answer;
 
-   /* Cancel alarm */
-   alarm(0);
    game_pause(1);
-   draw_grid();
+   draw_grid(&board);
    scrl_open=1;
 
    answer = malloc(21);
 
 redraw:
    width = clamp(col*0.7, col*0.7, 60);
-   dialog = newwin(8, width, row * 0.3, col*0.5 - width/2);
+   dialog = place_window(dialog, 8, width, row * 0.3, col*0.5 - width/2);
+   werase(dialog);
 
    /* Draw dialog */
    wbkgd(dialog, COLOR_PAIR(C_DIALOG));
@@ -147,22 +144,19 @@ redraw:
 
    /* Draw over top of everything */
    overwrite(dialog, stats);
-   wrefresh(dialog);
+   frame_refresh(dialog);
 
    /* Handle input */
    while ((c = getkey())) {
       switch (c) {
          case KEY_RESIZE:
-            getmaxyx(stdscr, row, col);
             draw_all();
             curs_set(1);
             goto redraw;
          /* Enter pressed */
          case 10:
             werase(dialog);
-            delwin(dialog);
             game_pause(0);
-            catch_alarm(0);
             fbar_time=0;
             scrl_open=0;
             return answer;
@@ -173,7 +167,7 @@ redraw:
                mvwprintw(dialog, 5, 3+apos, " ");
                answer[--apos] = '\0';
                wmove(dialog, 5, 4+apos);
-               wrefresh(dialog);
+               frame_refresh(dialog);
             }
             break;
          default:
@@ -186,7 +180,7 @@ redraw:
                answer[++apos]='\0';
                mvwaddch(dialog, 5, 3+apos, c);
                wmove(dialog, 5, 4+apos);
-               wrefresh(dialog);
+               frame_refresh(dialog);
             }
             break;
       }
@@ -0,0 +1,233 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+
+/* frame.c
+ * -------
+ * Rather than drawing and updating the screen straight away, the rest
+ * of nsuds marks what needs redrawing with frame_dirty(). Just before
+ * waiting for input, it's all drawn and the terminal is updated with a
+ * single doupdate(). If more input is already waiting, it's handled
+ * first, so a burst of keys (or keys and a timer tick) share a frame.
+ *
+ * Waiting for input is the event loop. The timer is run from poll()
+ * timeouts, and signals are passed through a pipe, so nothing is ever
+ * drawn from a signal handler. Work that can be put off (like reading
+ * in a long file) is done in small pieces while there's no input. */
+#include "config.h"
+
+#define _XOPEN_SOURCE 500
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#ifdef HAVE_NCURSES_H
+   #include <ncurses.h>
+#else
+   #include <curses.h>
+#endif
+
+#include "nsuds.h"
+#include "board.h"
+#include "grid.h"
+#include "timer.h"
+#include "frame.h"
+#include "trace.h"
+
+static int dirty=0;    /* Regions waiting to be drawn */
+static int skipped=0;  /* Frames skipped for typeahead */
+static int coalesce=1; /* Skip frames for typeahead? */
+static int sigpipe[2]={-1, -1}; /* Signals waiting to be handled */
+static int waiting=0;  /* frame_getch() calls in progress (dialogs nest) */
+static int (*idle)(void *)=NULL; /* Background work, see frame_idle() */
+static void *idle_arg;
+static int idle_depth; /* Only run while this many getch()s deep */
+long frame_count=0;    /* Frames drawn */
+
+static int typeahead_waiting(void);
+static int buffered_key(void);
+static int wait_key(int ms);
+static void handle_signals(void);
+
+/* Set up the pipe signals are passed through. Returns 0 on failure. */
+int frame_init(void)
+{
+   int i;
+
+   if (pipe(sigpipe) == -1) return 0;
+   for (i=0; i<2; i++) {
+      fcntl(sigpipe[i], F_SETFL, O_NONBLOCK);
+      fcntl(sigpipe[i], F_SETFD, FD_CLOEXEC);
+   }
+   return 1;
+}
+
+/* Signal handler that passes the signal on to the event loop,
+ * which hands it to catch_signal() */
+void frame_signal(int sig)
+{
+   unsigned char s = sig;
+   int e = errno;
+
+   write(sigpipe[1], &s, 1);
+   errno = e;
+}
+
+/* Mark part of the screen as needing to be redrawn
+ * in the next frame */
+void frame_dirty(int regions)
+{
+   dirty |= regions;
+}
+
+/* Copy a window to the virtual screen, ready for the next frame.
+ * Use this rather than wnoutrefresh(), so it can be traced. */
+void frame_refresh(WINDOW *win)
+{
+   wnoutrefresh(win);
+   trace_refresh();
+}
+
+/* Turn off (or on) putting off frames while there's typeahead */
+void frame_coalesce(int on)
+{
+   coalesce = on;
+}
+
+/* Draw everything that's dirty, and update the terminal */
+void frame_flush(void)
+{
+   int d;
+
+   d = dirty;
+   dirty = 0;
+   if ((d & FRAME_FBAR) && !fbar_time) hide_fbar();
+   if (d & FRAME_TIMER) update_timer();
+   if (d & FRAME_STATS) draw_stats();
+   if (d & FRAME_GRID) draw_grid_contents(&board);
+   /* Drawing other windows leaves the cursor in them, so
+    * put it back where it is on stdscr */
+   if (d) frame_refresh(stdscr);
+   trace_frame_start(d);
+   doupdate();
+   trace_frame_end();
+   frame_count++;
+   skipped=0;
+}
+
+/* Run fn(arg) a piece at a time while waiting for input, until it
+ * returns 0. It only runs while its caller is the one waiting for a key,
+ * not while a dialog over the top is. NULL stops it. */
+void frame_idle(int (*fn)(void *), void *arg)
+{
+   idle = fn;
+   idle_arg = arg;
+   idle_depth = waiting + 1;
+}
+
+/* getch(), bringing the screen up to date first, unless more input
+ * is already waiting. Runs the timer and handles any signals while
+ * it waits. */
+int frame_getch(void)
+{
+   return frame_getch_timeout(-1);
+}
+
+/* frame_getch(), but give up and return ERR if no key comes within
+ * ms milliseconds. -1 waits for ever. */
+int frame_getch_timeout(int ms)
+{
+   int c;
+
+   waiting++;
+   c = wait_key(ms);
+   waiting--;
+   return c;
+}
+
+static int wait_key(int ms)
+{
+   struct pollfd p[2];
+   int c, busy, n, wait;
+   long until = ms < 0 ? -1 : clock_ms() + ms;
+
+   for (;;) {
+      while (timer_wait() == 0) timer_tick();
+      if (!coalesce || !typeahead_waiting() || ++skipped > FRAME_MAX_SKIP)
+         frame_flush();
+      /* ncurses can have keys of its own, that poll() won't see:
+       * the rest of an escape sequence, or a KEY_RESIZE */
+      if ((c = buffered_key()) != ERR) return c;
+
+      p[0].fd = STDIN_FILENO;
+      p[0].events = POLLIN;
+      p[1].fd = sigpipe[0];
+      p[1].events = POLLIN;
+      wait = timer_wait();
+      if (until != -1) {
+         if (clock_ms() >= until) return ERR;
+         if (wait < 0 || until - clock_ms() < wait) wait = until - clock_ms();
+      }
+      busy = idle && waiting == idle_depth;
+      n = poll(p, 2, busy ? 0 : wait);
+      if (n == -1) continue;
+      if (n == 0 && busy && !idle(idle_arg)) idle = NULL;
+      if (p[1].revents) handle_signals();
+      if (p[0].revents) {
+         wnoutrefresh(stdscr);
+         return getch();
+      }
+   }
+}
+
+/* A key that's ready now, including any ncurses has kept back.
+ * ERR if there isn't one. getch() refreshes stdscr if it has changed,
+ * which would draw a frame that's being put off, so queue stdscr with
+ * the other windows first. */
+static int buffered_key(void)
+{
+   int c;
+
+   wnoutrefresh(stdscr);
+   nodelay(stdscr, TRUE);
+   c = getch();
+   nodelay(stdscr, FALSE);
+   return c;
+}
+
+/* Handle the signals passed on by frame_signal() */
+static void handle_signals(void)
+{
+   unsigned char s;
+
+   while (read(sigpipe[0], &s, 1) == 1)
+      catch_signal(s);
+}
+
+/* Is there input waiting that hasn't been read yet? */
+static int typeahead_waiting(void)
+{
+   struct pollfd p;
+
+   p.fd = STDIN_FILENO;
+   p.events = POLLIN;
+   return poll(&p, 1, 0) > 0;
+}
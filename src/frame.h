@@ -0,0 +1,46 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+#ifndef _NSUDS_FRAME_H
+#define _NSUDS_FRAME_H
+
+/* Parts of the screen that can be waiting to be redrawn */
+#define FRAME_GRID   1  /* Changed squares, see draw_grid_contents() */
+#define FRAME_STATS  2
+#define FRAME_TIMER  4
+#define FRAME_FBAR   8  /* Function bar has timed out and should be hidden */
+#define FRAME_CURSOR 16 /* Cursor was moved on stdscr */
+
+/* Most keys in a row handled without updating the screen,
+ * while more input is waiting */
+#define FRAME_MAX_SKIP 32
+
+extern long frame_count;
+
+extern int frame_init(void);
+extern void frame_signal(int sig);
+extern void frame_dirty(int regions);
+extern void frame_coalesce(int on);
+extern void frame_refresh(WINDOW *win);
+extern void frame_flush(void);
+extern void frame_idle(int (*fn)(void *), void *arg);
+extern int frame_getch(void);
+extern int frame_getch_timeout(int ms);
+
+#endif
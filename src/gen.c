@@ -39,7 +39,7 @@
 #include <stdbool.h>
 #include <sys/time.h>
 
-#include "grid.h"
+#include "gen.h"
 
 /* Random number in the range [a,b] */
 #define rrand(a,b) (int)(((double)rand()/((double)RAND_MAX + 1)*(b-a + 1)) + a)
@@ -48,12 +48,11 @@ static short grid[82];  /* The puzzle grid itself */
 static int clues=0;     /* Number of clues in puzzle */
 
 /* Headers */
-extern char grid_data[9][9];
 static int solve();
 
-/* Generate a puzzle, put the result in grid_data.
- * Have atleast [filled] squares filled in. */
-void do_generate(int filled)
+/* Generate a puzzle, put the result in puzzle, with each given
+ * stored negated. Have atleast [filled] squares filled in. */
+void do_generate(char puzzle[9][9], int filled)
 {
    int i,j, valid;
    struct timeval tm;
@@ -111,14 +110,27 @@ void do_generate(int filled)
       if (solve() != 1) grid[rorder[i]] = old;
    }
 
-   /* Transfer grid to grid_data in grid.c */
+   /* Transfer grid to the puzzle */
    for (i = 0; i < 9; i++) {
       for (j = 0; j < 9; j++) {
-         grid_data[i][j] = - grid[i * 9 + j + 1];
+         puzzle[i][j] = - grid[i * 9 + j + 1];
       }
    }
 }
 
+/* How many ways can a partly filled grid be finished?
+ * Returns 0, 1, or 2 for more than one, like solve() */
+int count_solutions(char cells[9][9])
+{
+   int i, j;
+
+   for (i = 0; i < 9; i++) {
+      for (j = 0; j < 9; j++) {
+         grid[i * 9 + j + 1] = abs(cells[i][j]);
+      }
+   }
+   return solve();
+}
 
 /* Check how many solutions the puzzle has.
  *  Returns:
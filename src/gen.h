@@ -20,7 +20,8 @@
 #ifndef _NSUDS_GEN_H
 #define _NSUDS_GEN_H
 
-extern void do_generate(int filled);
+extern void do_generate(char puzzle[9][9], int filled);
+extern int count_solutions(char cells[9][9]);
 
 #endif
 
@@ -25,21 +25,13 @@
    #include <curses.h>
 #endif
 
-#if STDC_HEADERS || HAVE_STRING_H
-   #include <string.h>
-#else /* Old system with only <strings.h> */
-   #include <strings.h>
-#endif
-
 #include "nsuds.h"
+#include "board.h"
 #include "grid.h"
-#include "marks.h"
+#include "save.h"
+#include "frame.h"
 
-static bool grid_valid(void);
-static void sub_move(int *a1, int *a2, int toward);
-
-char grid_data[9][9]={{0}}; /* grid_data[y/row][x/col] */
-int curx=0,cury=0;          /* Current (selected) grid coords */
+static void sub_move(struct board *b, int *a1, int *a2, int toward);
 
 /* Get screen coords from grid coords */
 #define gy2scr(y) (3  + (y * 2))
@@ -51,46 +43,46 @@ int curx=0,cury=0;          /* Current (selected) grid coords */
 #define scry2g(y) ((y - 3) / 2)
 #define scrx2g(x) ((x - 30) / 4)
 /* Move grid cursor to grid coord */
-#define gmove(y, x) wmove(grid, gy2win(y), gx2win(x))
+#define gmove(b, y, x) wmove((b)->win, gy2win(y), gx2win(x))
 /* Move grid cursor to left of grid coord */
-#define gmovel(y, x) wmove(grid, gy2win(y), gx2win(x)-1)
+#define gmovel(b, y, x) wmove((b)->win, gy2win(y), gx2win(x)-1)
 /* Move screen cursor to grid coord */
-#define smove(y, x) move(gy2scr(y), gx2scr(x))
+#define smove(y, x) (move(gy2scr(y), gx2scr(x)), frame_dirty(FRAME_CURSOR))
 
 /* Move cursor to another grid space */
-void movec(int dir)
+void movec(struct board *b, int dir)
 {
    switch (dir) {
       case UP:
-         if (cury > 0) smove(--cury, curx);
+         if (b->cury > 0) smove(--b->cury, b->curx);
          break;
       case DOWN:
-         if (cury < 8) smove(++cury, curx);
+         if (b->cury < 8) smove(++b->cury, b->curx);
          break;
       case LEFT:
-         if (curx > 0) smove(cury, --curx);
+         if (b->curx > 0) smove(b->cury, --b->curx);
          break;
       case RIGHT:
-         if (curx < 8) smove(cury, ++curx);
+         if (b->curx < 8) smove(b->cury, ++b->curx);
          break;
 
       /* Go to the center of the an adjacent sub-square */
       case SUB_RIGHT:
-         sub_move(&curx, &cury, 9);
+         sub_move(b, &b->curx, &b->cury, 9);
          break;
       case SUB_LEFT:
-         sub_move(&curx, &cury, 0);
+         sub_move(b, &b->curx, &b->cury, 0);
          break;
       case SUB_UP:
-         sub_move(&cury, &curx, 0);
+         sub_move(b, &b->cury, &b->curx, 0);
          break;
       case SUB_DOWN:
-         sub_move(&cury, &curx, 9);
+         sub_move(b, &b->cury, &b->curx, 9);
          break;
 
       /* Move to current position (after a redraw) */
       case CUR:
-         smove(cury, curx);
+         smove(b->cury, b->curx);
          break;
    }
 }
@@ -99,7 +91,7 @@ void movec(int dir)
 /* Move to the center of an adjacent subsection by:
  *  - Moving along axis1 toward the cell 'toward' 
  *  - Centering axis2 */
-static void sub_move(int *a1, int *a2, int toward) {
+static void sub_move(struct board *b, int *a1, int *a2, int toward) {
    /* Moving along axis1 toward 0 */
    if (toward == 0) {
       if (*a1 <= 2) return;
@@ -117,14 +109,14 @@ static void sub_move(int *a1, int *a2, int toward) {
    else if (*a2 >= 3 && *a2 <= 4) *a2=4;
    else *a2=7;
 
-   smove(cury, curx);
+   smove(b->cury, b->curx);
 }
 
    
 
 /* Move to specified screen location, if user
  * clicked on a valid grid square */
-void movec_mouse(int x, int y)
+void movec_mouse(struct board *b, int x, int y)
 {
    int gx, gy;
    /* Get grid coords from screen coords.
@@ -135,87 +127,28 @@ void movec_mouse(int x, int y)
    /* If user clicked on a valid square, move to it */
    if (gx >= 0 && gx < 9 &&
        gy >= 0 && gy < 9) {
-          cury = gy;
-          curx = gx;
-          smove(cury,curx);
+          b->cury = gy;
+          b->curx = gx;
+          smove(b->cury, b->curx);
    }
 }
 
 
 /* Fill in the current grid location */
-void gsetcur(char ch)
+void gsetcur(struct board *b, char ch)
 {
    /* If char is immutable, do nothing */
-   if (grid_data[cury][curx]<0) return;
+   if (!board_set(b, b->cury, b->curx, ch)) return;
 
-   gmove(cury,curx);
-   grid_data[cury][curx] = ch;
-   draw_grid();
+   autosave_cell(b->cury, b->curx, ch);
+   frame_dirty(FRAME_GRID);
 
    /* Check if compelted */
-   if (grid_filled() == 81 && grid_valid())
+   if (b->st.filled == 81 && board_valid(b))
       game_win();
 }
 
 
-/* Check if a full or partially filled
- * sudoku grid is valid or not */
-static bool grid_valid(void)
-{
-   int i,j,k;
-   char rowf[9], colf[9];
-
-   /* Check rows/cols */
-   for (i=0; i<9; i++) {
-      /* Reset row/col finds */
-      memset(&rowf, 0, 9);
-      memset(&colf, 0, 9);
-
-      /* Add finds to colf/rowf */
-      for (j=0; j<9; j++) {
-         if (abs(grid_data[i][j])) colf[abs(grid_data[i][j])-1]++;
-         if (abs(grid_data[j][i])) rowf[abs(grid_data[j][i])-1]++;
-      }
-      
-      /* Check if a number was found more than once per
-       * row/col */
-      for (j=0; j<9; j++) {
-         if (colf[j] > 1 || rowf[j] > 1) return 0;
-      }
-   }
-
-   /* Check segments (segment start=(i,j)) */
-   for (i=0; i<9; i+=3) {
-      for (j=0; j<9; j+=3) {
-         memset(&rowf, 0, 9);
-         
-         /* Check #'s within each segment */
-         for (k=0;k<3;k++) {
-            if (abs(grid_data[i+k][j]))   rowf[abs(grid_data[i+k][j])-1]++;
-            if (abs(grid_data[i+k][j+1])) rowf[abs(grid_data[i+k][j+1])-1]++;
-            if (abs(grid_data[i+k][j+2])) rowf[abs(grid_data[i+k][j+2])-1]++;
-         }
-
-         for (k=0; k<9; k++) {
-            if (rowf[k] > 1) return 0;
-         }
-      }
-   }
-
-   return 1;
-}
-
-/* Return how many squares in the grid are filled, for stats window. */
-int grid_filled(void)
-{
-   int i, j, ret=0;
-   for (i=0; i<9; i++)
-      for (j=0;j<9;j++)
-         if (grid_data[i][j]) ret++;
-   return ret;
-}
-
-
 /* Attributes for nubmer we're highlighting */
 static attr_t show_attr(int mark, int uline)
 {
@@ -241,59 +174,69 @@ static attr_t show_attr(int mark, int uline)
 }
 
 /* Attribute for a regular number, user inputted or a default */
-static attr_t user_attr(int user)
+static attr_t user_attr(struct board *b, int y, int x)
 {
-   return (user > 0 && use_colors ? COLOR_PAIR(C_INPUT) : 0);
+   return (!board_given(b, y, x) && use_colors ? COLOR_PAIR(C_INPUT) : 0);
 }
 
-/* Draw the contents of the grid, including mark highlighting (if set) */
-void draw_grid_contents(void)
+/* Draw the squares that have changed since they were last drawn,
+ * including mark highlighting (if set). Each square is painted in
+ * full, so the window doesn't need to be cleared first. */
+void draw_grid_contents(struct board *b)
 {
-   int i, j, k;
+   int i, j, k, h, w;
 
-   if (is_paused()) return;
+   if (is_paused() || !b->win) return;
+   /* The window is cut down if the terminal is too small */
+   getmaxyx(b->win, h, w);
 
-   /* For each square */
    for (i=0; i<9; i++) {
+      if (!b->dirty[i]) continue;
       for (j=0; j<9; j++) {
+         if (!(b->dirty[i] & (1 << j))) continue;
+         /* Skip squares that don't fit, rather than wrapping */
+         if (gy2win(i) >= h || gx2win(j) + 1 >= w) continue;
+
          /* Move to the square */
-         gmovel(i, j);
+         gmovel(b, i, j);
 
          /* If we're not highlighting any marks */
-         if (!showmarks[1]) {
-            if (grid_data[i][j]) {
+         if (!b->showmarks[1]) {
+            waddch(b->win, ' ');
+            if (b->st.cells[i][j]) {
                /* Square is filled, show */
-               waddch(grid, ' ');
-               waddch(grid, (abs(grid_data[i][j]) + '0') | user_attr(grid_data[i][j]));
-            }
+               waddch(b->win, (b->st.cells[i][j] + '0') | user_attr(b, i, j));
+            } else waddch(b->win, ' ');
+            waddch(b->win, ' ');
          /* If we're highlighting something */
          } else {
             int output=0; /* Have we output a number? */
 
             /* For each of the 3 positions */
             for (k=0; k <= 2; k++) {
-               if (showmarks[k]) {
+               if (b->showmarks[k]) {
                   /* Square is filled with a number to be highlighted */
-                  if (abs(grid_data[i][j]) == showmarks[k]) {
+                  if (b->st.cells[i][j] == b->showmarks[k]) {
                      output=1;
-                     waddch(grid, (abs(grid_data[i][j]) + '0') | show_attr(k+1,1));
+                     waddch(b->win, (b->st.cells[i][j] + '0') | show_attr(k+1,1));
                   /* Square is empty, but a mark is set */
-                  } else if (!grid_data[i][j] && marks[i][j][showmarks[k]]) {
+                  } else if (!b->st.cells[i][j] &&
+                        (b->st.marks[i][j] & MARK(b->showmarks[k]))) {
                      output=1;
-                     waddch(grid, (showmarks[k] + '0') | show_attr(k+1,0));
-                  } else waddch(grid, ' ');
-               } else waddch(grid, ' ');
+                     waddch(b->win, (b->showmarks[k] + '0') | show_attr(k+1,0));
+                  } else waddch(b->win, ' ');
+               } else waddch(b->win, ' ');
             } 
 
             /* Grid is filled, but it isn't anything we're highlighting */
-            if (grid_data[i][j]  && !output) {
-                  gmove(i,j);
-                  waddch(grid, (abs(grid_data[i][j]) + '0') | user_attr(grid_data[i][j]));
+            if (b->st.cells[i][j]  && !output) {
+                  gmove(b, i, j);
+                  waddch(b->win, (b->st.cells[i][j] + '0') | user_attr(b, i, j));
             }
          }
       }
+      b->dirty[i] = 0;
    }
 
-   wnoutrefresh(grid);
+   frame_refresh(b->win);
 }
-
@@ -22,13 +22,10 @@
 #define _NSUDS_GRID_H
 
 enum {CUR, LEFT, RIGHT, UP, DOWN, SUB_LEFT, SUB_RIGHT, SUB_UP, SUB_DOWN};
-#define abs(x) (((x)>0)?(x):-(x))
-extern int curx,cury;    /* Current (selected) grid coords */
 
-extern void movec(int dir);
-extern void movec_mouse(int x, int y);
-extern void gsetcur(char ch);
-extern int grid_filled(void);
-extern void draw_grid_contents(void);
+extern void movec(struct board *b, int dir);
+extern void movec_mouse(struct board *b, int x, int y);
+extern void gsetcur(struct board *b, char ch);
+extern void draw_grid_contents(struct board *b);
 #endif
 
@@ -0,0 +1,44 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+#ifndef _NSUDS_HELP_H
+#define _NSUDS_HELP_H
+
+/* A line of a compiled help file. Offsets are into the file's arena,
+ * laid out the same way as a scroller's. */
+struct help_line {
+   long text;
+   long runs;
+   int len;
+   int nruns;
+};
+
+/* A help file, parsed at build time by mkhelp */
+struct helpfile {
+   char *name;
+   const unsigned char *arena;
+   long size;
+   const struct help_line *lines;
+   int nlines;
+};
+
+/* Every help file, ending with a NULL name (in the generated helpdata.c) */
+extern const struct helpfile helpfiles[];
+
+#endif
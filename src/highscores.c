@@ -35,10 +35,42 @@
 
 #include "highscores.h"
 #include "nsuds.h"
+#include "board.h"
 #include "util.h"
 #include "scroller.h"
 
+static Scroller *load_scores(struct stat *f);
+
+/* Show the high scores. The scroller is kept after it's closed, and
+ * only read in again if the score file has changed. */
 void display_scores(void)
+{
+   static Scroller *s;
+   static struct stat loaded; /* Score file, when it was read in */
+   struct stat f;
+
+   if (s && stat(SCOREDIR "high_scores", &f) == 0 &&
+         f.st_mtime == loaded.st_mtime && f.st_size == loaded.st_size) {
+      scroller_reopen(s);
+   } else {
+      if (s) free_scroller(s);
+      s = load_scores(&loaded);
+   }
+
+   /* Allow draws again (and draw) */
+   scroller_set(s, SCRL_RFRESH, 1);
+
+   /* Place over everything */
+   overwrite(s->window, board.win);
+
+   /* Handle user input */
+   scroller_input_loop(s);
+}
+
+/* Read the score file into a new scroller, and stat it into f. If it
+ * can't be read, f's size is set to -1, so it's never taken as
+ * unchanged. */
+static Scroller *load_scores(struct stat *f)
 {
    FILE *fd;
    Scroller *s;
@@ -47,6 +79,7 @@ void display_scores(void)
      "High Scores");
    /* Don't draw until we're done adding lines */
    scroller_set(s, SCRL_RFRESH, 0);
+   f->st_size = -1;
    
    /* Read in the file */
    fd=fopen(SCOREDIR "high_scores", "r");
@@ -54,10 +87,10 @@ void display_scores(void)
       scroller_write(s, "Error: Can't access high score file!");
       scroller_write(s, "Are you sure you installed nsuds correctly?");
    } else {
-      struct stat f;
-      if (stat(SCOREDIR "high_scores", &f) == -1) 
+      if (stat(SCOREDIR "high_scores", f) == -1) {
+         f->st_size = -1;
          scroller_write(s, "Error: Can't stat high score file");
-      else if (f.st_size == 0) 
+      } else if (f->st_size == 0) 
          scroller_write(s, "Error: High score file empty!");
       else {
          char *buffer, *record;
@@ -108,17 +141,6 @@ void display_scores(void)
       }
       fclose(fd);
    }
-
-   /* Allow draws again (and draw) */
-   scroller_set(s, SCRL_RFRESH, 1);
-
-   /* Place over everything */
-   overwrite(s->window, grid);
-
-   /* Handle user input */
-   scroller_input_loop(s);
-
-   /* User has closed the scroller, free it */
-   free_scroller(s);
+   return s;
 }
 
@@ -26,115 +26,158 @@
 #endif
 
 #include "nsuds.h"
+#include "board.h"
 #include "marks.h"
 #include "grid.h"
-
-bool marks[9][9][9] = {{{0}}};
-short showmarks[3]={0};
+#include "save.h"
+#include "frame.h"
 
 /* Headers */
-static int ask_int(char *question, ...);
+static int ask_int(struct board *b, char *question, ...);
 
 /* Mark current square with a number.  Similar to
  * writing a pencilmark in the square, indicating
  * a possible candidate */
-void mark_square(void)
+void mark_square(struct board *b)
 {
    int num;
-   num = ask_int("Mark square with which number? (1-9)");
+   num = ask_int(b, "Mark square with which number? (1-9)");
    if (!num) return;
-   marks[cury][curx][num]=1;
+   board_mark(b, b->cury, b->curx, num, 1);
+   autosave_mark(b->cury, b->curx, num, 1);
 
-   if (showmarks[0] == num 
-      || showmarks[1]==num 
-      || showmarks[2]) 
-      draw_grid();
+   frame_dirty(FRAME_GRID);
 }
 
 
 /* Show all marks for a number. Basically shows
  * all the squares that the user has marked as
  * candidates for that number. */
-void marks_show(enum show_type type)
+void marks_show(struct board *b, enum show_type type)
 {
    int num;
 
    switch(type) {
       default:
       case ONE:
-         num = ask_int("Reveal squares marked with which number? (1-9)");
-         showmarks[1]=num;
-         showmarks[0]=showmarks[2]=0;
-         draw_grid();
+         num = ask_int(b, "Reveal squares marked with which number? (1-9)");
+         b->showmarks[1]=num;
+         b->showmarks[0]=b->showmarks[2]=0;
          break;
       case MULTIPLE:
-         num = ask_int("Reveal squares marked with which numbers? (1-9)");
+         num = ask_int(b, "Reveal squares marked with which numbers? (1-9)");
          if (!num) {
-            showmarks[0]=showmarks[1]=showmarks[2]=0;
+            b->showmarks[0]=b->showmarks[1]=b->showmarks[2]=0;
             goto done;
          }
-         showmarks[0]=num;
+         b->showmarks[0]=num;
 
 second:
-         num = ask_int("%d and..? (1-9, Enter for just `%d')", 
-             showmarks[0], showmarks[0]);
+         num = ask_int(b, "%d and..? (1-9, Enter for just `%d')", 
+             b->showmarks[0], b->showmarks[0]);
          if (!num) {
-            showmarks[1] = showmarks[0];
-            showmarks[0]=showmarks[2]=0;
+            b->showmarks[1] = b->showmarks[0];
+            b->showmarks[0]=b->showmarks[2]=0;
             goto done;
          }
-         if (num==showmarks[0]) goto second;
-         showmarks[1]=num;
+         if (num==b->showmarks[0]) goto second;
+         b->showmarks[1]=num;
 
 third:
-         num = ask_int("%d,%d and..? (1-9, Enter for just `%d,%d')", 
-             showmarks[0], showmarks[1], showmarks[0], showmarks[1]);
+         num = ask_int(b, "%d,%d and..? (1-9, Enter for just `%d,%d')", 
+             b->showmarks[0], b->showmarks[1],
+             b->showmarks[0], b->showmarks[1]);
          if (!num) {
-            showmarks[2]=0;
+            b->showmarks[2]=0;
             goto done;
          }
-         if (num == showmarks[0] || num == showmarks[1]) goto third;
-         showmarks[2]=num;
+         if (num == b->showmarks[0] || num == b->showmarks[1]) goto third;
+         b->showmarks[2]=num;
 done:
-         draw_grid();
+         break;
    }
+   /* What's highlighted may have changed anywhere */
+   board_touch_all(b);
+   frame_dirty(FRAME_GRID);
 }
 
 
 /* Clear all marks for a number. */
-void marks_clear(enum clear_type type)
+void marks_clear(struct board *b, enum clear_type type)
 {
    int num;
-   int i, j;
 
    switch (type) {
       default:
       case SINGLE:
-         num = ask_int("Clear which mark from this square? (1-9)");
+         num = ask_int(b, "Clear which mark from this square? (1-9)");
          if (!num) return;
-         marks[cury][curx][num]=0;
+         board_mark(b, b->cury, b->curx, num, 0);
+         autosave_mark(b->cury, b->curx, num, 0);
          break;
       case ALL:
-         num = ask_int("Clear all marks for which number? (1-9)");
+         num = ask_int(b, "Clear all marks for which number? (1-9)");
          if (!num) return;
 
-         for (i=0; i<9; i++) {
-            for (j=0; j<9; j++) {
-               marks[i][j][num]=0;
-            }
-         }
+         board_clear_marks(b, num);
+         autosave_clear_marks(num);
          break;
    }
-   if (showmarks[0] == num 
-      || showmarks[1]==num 
-      || showmarks[2]) 
-      draw_grid();
+   frame_dirty(FRAME_GRID);
+}
+
+
+/* Start a try, so the player can guess and later roll back */
+void try_begin(struct board *b)
+{
+   if (!board_try(b)) {
+      ask_int(b, "Can't nest tries more than %d deep", BOARD_TRIES);
+   }
+   frame_dirty(FRAME_STATS);
 }
 
+/* Roll the board back to the start of a try */
+void try_rollback(struct board *b)
+{
+   int num;
+
+   if (!b->ntries) return;
+   if (b->ntries == 1) {
+      num = 1;
+   } else {
+      num = ask_int(b, "Roll back to the start of which try? "
+         "(1-%d, Enter for %d)", b->ntries, b->ntries);
+      if (!num) num = b->ntries;
+      if (num > b->ntries) return;
+   }
+   board_rollback(b, num);
+   /* Too much may have changed to journal it */
+   autosave_snapshot();
+   frame_dirty(FRAME_GRID);
+   frame_dirty(FRAME_STATS);
+}
+
+/* Keep the board as it is, ending a try */
+void try_commit(struct board *b)
+{
+   int num;
+
+   if (!b->ntries) return;
+   if (b->ntries == 1) {
+      num = 1;
+   } else {
+      num = ask_int(b, "Keep everything since the start of which try? "
+         "(1-%d, Enter for %d)", b->ntries, b->ntries);
+      if (!num) num = b->ntries;
+      if (num > b->ntries) return;
+   }
+   board_commit(b, num);
+   frame_dirty(FRAME_STATS);
+}
 
 /* Ask user for an integer input.
  * Returns 1-9 or 0 for anything else */
-static int ask_int(char *question, ...)
+static int ask_int(struct board *b, char *question, ...)
 {
    va_list ap;
    int c;
@@ -145,7 +188,7 @@ static int ask_int(char *question, ...)
    va_start(ap, question);
    vwprintw(stdscr, question, ap);
    va_end(ap);
-   movec(CUR);
+   movec(b, CUR);
 
    /* Wait for input */
    while ((c = getkey())) {
@@ -154,9 +197,8 @@ static int ask_int(char *question, ...)
          return 0;
       }
       /* Real input occured, erase line */
-      if (row <= 30) mvhline(row-1, 0, ACS_CKBOARD, col);
-      else mvhline(row-1, 0, ' ', col);
-      movec(CUR);
+      mvhline(row-1, 0, BACKGROUND, col);
+      movec(b, CUR);
       /* Return int or invalid */
       if (c>='1' && c<='9') {
          return c - '0';
@@ -20,14 +20,15 @@
 #ifndef _NSUDS_MARKS_H
 #define _NSUDS_MARKS_H
 
-extern bool marks[9][9][9];
-short showmarks[3];
 enum clear_type {SINGLE, ALL};
 enum show_type {ONE, MULTIPLE};
 
-extern void mark_square(void);
-extern void marks_show(enum show_type type);
-extern void marks_clear(enum clear_type type);
+extern void mark_square(struct board *b);
+extern void marks_show(struct board *b, enum show_type type);
+extern void marks_clear(struct board *b, enum clear_type type);
+extern void try_begin(struct board *b);
+extern void try_rollback(struct board *b);
+extern void try_commit(struct board *b);
 
 #endif
 
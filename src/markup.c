@@ -0,0 +1,101 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+
+/* markup.c
+ * --------
+ * Parses the formatting characters used in scrollers and the help
+ * files into plain text, and runs of formatting: a flags byte followed
+ * by a length byte for each run. Kept apart from the scroller, as the
+ * help files are parsed with it at build time too (see mkhelp.c). */
+#include "config.h"
+
+#include "markup.h"
+
+/* Length of n characters of text, minus the formatting characters */
+int markup_len(const char *msg, long n)
+{
+   const char *c, *end = msg + n;
+   int len=0;
+
+   for (c=msg; c < end; c++) {
+      switch (*c) {
+         case '_':
+         case '{':
+         case '}':
+         case '%':
+            break;
+         default:
+            len++;
+            break;
+      }
+   }
+   return len;
+}
+
+/* Parse n characters of text, copying the plain text into text (with a
+ * '\0' after it), and its formatting into runs. A newline is shown as a
+ * space. runs needs room for two bytes per character, in the worst case.
+ * Returns the number of runs. */
+int markup_parse(const char *msg, long n, char *text, unsigned char *runs)
+{
+   const char *c, *end = msg + n;
+   int flags, nruns=0;
+   int in_ul=0, in_cyan=0, in_red=0; /* Formatting attributes */
+   unsigned char *last = runs;
+
+   /* Parse out formatting characters, and copy over
+    * all other characters, with runs of formatting */
+   for (c=msg; c < end; c++) {
+         switch (*c) {
+            /* _Underlined text_  normal */
+            case '_':
+               in_ul=!in_ul;
+               break;
+               /* { Cyan text } normal */
+            case '{':
+               in_cyan=1;
+               break;
+            case '}':
+               in_cyan=0;
+               break;
+               /* %Red text% normal */
+            case '%':
+               in_red = !in_red;
+               break;
+            default:
+               *text++ = *c == '\n' ? ' ' : *c;
+               /* Red OR cyan */
+               flags = in_cyan ? SCRL_KEY : in_red ? SCRL_URGENT : 0;
+               /* Can be combined with underline */
+               if (in_ul) flags |= SCRL_UL;
+               /* Start a new run if the formatting changes */
+               if (nruns && last[0] == flags && last[1] < 255) {
+                  last[1]++;
+               } else {
+                  last = runs + nruns++ * 2;
+                  last[0] = flags;
+                  last[1] = 1;
+               }
+               break;
+         }
+   }
+   *text = '\0';
+   return nruns;
+}
@@ -38,7 +38,9 @@
 #include "menu.h"
 #include "highscores.h"
 #include "nsuds.h"
+#include "board.h"
 #include "util.h"
+#include "frame.h"
 
 /* Structs */
 struct item {
@@ -91,8 +93,7 @@ static Menu *menu_new(int height, int width, int starty, int startx, char *title
 /* Resize a menu, e.g after a SIGWINCH */
 static void menu_resize(Menu *m, int height, int width, int starty, int startx)
 {
-   delwin(m->window);
-   m->window = newwin(height, width, starty, startx);
+   m->window = place_window(m->window, height, width, starty, startx);
    m->height = height;
    m->width = width;
 }
@@ -132,7 +133,7 @@ static void draw_menu(Menu *m)
        }
    }
 
-   wrefresh(m->window);
+   frame_refresh(m->window);
 }
 
 /* Scroll a menu, i.e select the previous or
@@ -246,12 +247,11 @@ int launch_menu(int height, int width, int starty, int startx,
    for (i=0; items[i]; i++) {
       menu_add_item(m, items[i]);
    }
-   overwrite(m->window, grid);
+   overwrite(m->window, board.win);
    draw_menu(m);
    while ((c = getkey())) {
       switch (c) {
          case KEY_RESIZE:
-            getmaxyx(stdscr, row, col);
             menu_resize(m, height, width, starty, startx);
             draw_all();
             draw_menu(m);
@@ -288,7 +288,7 @@ int launch_menu(int height, int width, int starty, int startx,
             ret = m->selected;
             goto done;
          case '?':
-            launch_file(HELPDIR "main", "Help with nsuds");
+            launch_help("main", "Help with nsuds");
             ungetch(KEY_RESIZE);
             break;
          case 'H':
@@ -0,0 +1,131 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+
+/* mkhelp.c
+ * --------
+ * Build tool that compiles the help files into C, so they're part of
+ * nsuds and don't need to be found, read or parsed at runtime. Each
+ * file's lines are parsed into an arena of text and formatting runs,
+ * ready to be copied straight into a scroller.
+ *
+ * Usage: mkhelp helpfile... > helpdata.c */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#if STDC_HEADERS || HAVE_STRING_H
+   #include <string.h>
+#else /* Old system with only <strings.h> */
+   #include <strings.h>
+#endif
+
+#include "markup.h"
+
+static char *read_file(char *fname, long *size);
+static void compile(char *fname, int n);
+
+int main(int argc, char **argv)
+{
+   int i;
+
+   if (argc < 2) {
+      fprintf(stderr, "Usage: %s helpfile...\n", argv[0]);
+      return 1;
+   }
+
+   printf("/* Generated by mkhelp from the help files, don't edit */\n");
+   printf("#include \"config.h\"\n\n");
+   printf("#include <stdio.h>\n\n");
+   printf("#include \"help.h\"\n");
+   for (i=1; i < argc; i++) compile(argv[i], i);
+
+   printf("\nconst struct helpfile helpfiles[] = {\n");
+   for (i=1; i < argc; i++) {
+      /* Named after the file, without its directory */
+      printf("   {\"%s\", arena%d, sizeof(arena%d), lines%d,\n"
+         "      sizeof(lines%d) / sizeof(struct help_line)},\n",
+         strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i],
+         i, i, i, i);
+   }
+   printf("   {NULL, NULL, 0, NULL, 0}\n};\n");
+   return 0;
+}
+
+/* Read in a whole file, exiting if it can't be */
+static char *read_file(char *fname, long *size)
+{
+   FILE *fd;
+   char *buf;
+
+   fd = fopen(fname, "rb");
+   if (fd == NULL || fseek(fd, 0, SEEK_END) || (*size = ftell(fd)) < 0) {
+      perror(fname);
+      exit(1);
+   }
+   rewind(fd);
+   buf = malloc(*size + 1);
+   if (!buf || fread(buf, 1, *size, fd) != (size_t)*size) {
+      perror(fname);
+      exit(1);
+   }
+   fclose(fd);
+   return buf;
+}
+
+/* Print the arena and line table of help file n */
+static void compile(char *fname, int n)
+{
+   char *file, *p, *nl, *arena;
+   long size, used=0, len, i;
+   int plain, nruns, nlines=0;
+
+   file = read_file(fname, &size);
+   /* Parsed text is never longer, and runs take at most
+    * two bytes per character (plus a '\0' for each line) */
+   arena = malloc(size * 3 + 1);
+   if (!arena) {
+      perror("mkhelp");
+      exit(1);
+   }
+
+   printf("\nstatic const struct help_line lines%d[] = {\n", n);
+   for (p=file; p < file + size; p += len) {
+      nl = memchr(p, '\n', file + size - p);
+      len = nl ? nl - p + 1 : file + size - p;
+      plain = markup_len(p, len);
+      nruns = markup_parse(p, len, arena + used,
+         (unsigned char *)arena + used + plain + 1);
+      printf("   {%ld, %ld, %d, %d},\n", used, used + plain + 1, plain, nruns);
+      used += plain + 1 + nruns * 2;
+      nlines++;
+   }
+   /* An empty table isn't allowed */
+   if (!nlines) printf("   {0, 0, 0, 0}\n");
+   printf("};\n");
+
+   printf("\nstatic const unsigned char arena%d[] = {", n);
+   for (i=0; i < used; i++)
+      printf("%s%d,", i % 16 ? "" : "\n   ", (unsigned char)arena[i]);
+   if (!used) printf("\n   0");
+   printf("\n};\n");
+
+   free(arena);
+   free(file);
+}
@@ -42,6 +42,7 @@
 
 #include "nsuds.h"
 #include "timer.h"
+#include "board.h"
 #include "grid.h"
 #include "gen.h"
 #include "marks.h"
@@ -50,6 +51,11 @@
 #include "menu.h"
 #include "highscores.h"
 #include "dialog.h"
+#include "save.h"
+#include "frame.h"
+#include "trace.h"
+#include "bench.h"
+#include "util.h"
 
 static void init_ncurses(void);
 static void init_windows(void);
@@ -57,8 +63,9 @@ static void draw_title(void);
 static void draw_xs(void);
 static void draw_fbar(void);
 static void init_signals(void);
-void catch_signal(int sig);
-static void generate(void);
+static void generate(char puzzle[9][9]);
+static void resume_game(void);
+static void drain_resize(void);
 
 
 enum {NEVER, AUTO, ALWAYS} colors_when=AUTO; /* For getopt */
@@ -66,10 +73,12 @@ enum {INTRO, IN_GAME} dmode=INTRO;           /* Display mode */
 static MEVENT mouse_e;
 static int paused=1;
 
-WINDOW *grid, *timer, *stats, *title, *fbar, *intro;
+WINDOW *timer, *stats, *title, *fbar, *intro;
+struct board board;   /* The board being played */
 int difficulty=0;
 int fbar_time = 0;   /* Seconds to keep fbar up */
 int use_colors=0;
+int low_bandwidth=0; /* Seconds between timer updates, or 0 for normal */
 int row,col;
 int scrl_open=0; /* Is a scroller open? */
 char *difficulties[] = {"Easy", "Medium", "Hard", "Expert", "Insane", NULL};
@@ -78,7 +87,8 @@ char level_times[][2] = {{20,0}, {17,30}, {15,0}, {10,0},   {7, 30}};
 /* Set up decent defaults */
 static void init_ncurses()
 {
-   initscr(); /* Enter curses */
+   /* Enter curses, unless the benchmark has set up a screen */
+   if (!bench_running()) initscr();
    if ((colors_when == AUTO && has_colors()) || colors_when==ALWAYS) {
       use_colors=1;
       start_color(); 
@@ -109,21 +119,26 @@ static void init_ncurses()
  * Scrollers as they're managed automatically. */
 static void init_windows(void)
 {
-   title = newwin(1, 64, 0, 1);
-   grid=newwin(19, 37, 2, 28);
-   timer = newwin(6, 25, 2, 1);
-   stats = newwin(13, 25, 8, 1);
-   fbar = newwin(1, col, row-1, 0);
-   intro = newwin(19, 37, 2, 28);
+   title = place_window(title, 1, 64, 0, 1);
+   board.win = place_window(board.win, 19, 37, 2, 28);
+   timer = place_window(timer, 6, 25, 2, 1);
+   stats = place_window(stats, 13, 25, 8, 1);
+   fbar = place_window(fbar, 1, col, row-1, 0);
+   intro = place_window(intro, 19, 37, 2, 28);
 }
 
-/* Set up all the signal handlers */
+/* Set up all the signal handlers. Fatal signals are handled straight
+ * away; the rest go through the event loop (see frame.c), so they're
+ * handled on the main path. */
 static void init_signals(void)
 {
-   struct sigaction new;
+   struct sigaction new, fatal;
+
+   if (!frame_init())
+      err(errno, "Can't set up signal handlers!");
 
    /* Set up signal handler */
-   new.sa_handler = catch_signal;
+   new.sa_handler = frame_signal;
    sigemptyset(&new.sa_mask);
    new.sa_flags = 0;
    
@@ -131,11 +146,14 @@ static void init_signals(void)
    /* Restart interrupted system calls */
    new.sa_flags |= SA_RESTART;
 #endif
+   fatal = new;
+   fatal.sa_handler = catch_signal;
    if (sigaction(SIGINT, &new, NULL) < 0  ||
        sigaction(SIGTERM, &new, NULL) < 0 || 
        sigaction(SIGQUIT, &new, NULL) < 0 || 
-       sigaction(SIGILL, &new, NULL) < 0  || 
-       sigaction(SIGSEGV, &new, NULL) < 0)
+       sigaction(SIGHUP, &new, NULL) < 0  || 
+       sigaction(SIGILL, &fatal, NULL) < 0  || 
+       sigaction(SIGSEGV, &fatal, NULL) < 0)
      err(errno, "Can't set up signal handlers!");
 }
 
@@ -147,6 +165,7 @@ void catch_signal(int sig)
       case SIGINT:
          /* Interrupt acts similar to the 'q' key */
          if (dmode == INTRO || confirm("Really quit?")) {
+            if (dmode == IN_GAME) autosave_snapshot();
             endwin();
             exit(EXIT_SUCCESS);
          }
@@ -155,59 +174,87 @@ void catch_signal(int sig)
          break;
       case SIGILL:
       case SIGSEGV:
-         /* Die nicely from a fatal error */
+         /* Die nicely from a fatal error, keeping the game */
+         autosave_emergency();
          endwin();
          errx(EXIT_FAILURE, "Segmentation fault!");
       case SIGQUIT:
       case SIGTERM:
-         /* Exit nicely from a kill */
+      case SIGHUP:
+         /* Exit nicely from a kill or a dropped connection */
+         autosave_emergency();
          endwin();
          exit(EXIT_FAILURE);
    }
 }
 
 
-void draw_grid(void)
+/* Draw the lines of the grid. They never change, so this is only
+ * done once, into a pad that's copied to the grid window. */
+static WINDOW *grid_frame(void)
 {
+   static WINDOW *pad;
    int i, j;
 
-   werase(grid);
+   if (pad) return pad;
+   pad = newpad(19, 37);
+   if (!pad) return NULL;
 
-   box(grid, 0, 0);
+   box(pad, 0, 0);
 
-   if (is_paused()) {
-      mvwaddstr(grid, 9, 15, "Paused");
-   } else {
+   /* Horizontal insides */
+   for (i=2; i<18; i+=2) {
+      if (i%6==0) continue;
+      mvwhline(pad, i, 1, '-', 35);
+   }
+   /* Vertical insides */
+   for (i=4; i<36; i+=4) {
+      if (i%12==0) continue;
+      mvwvline(pad, 1, i, '|', 17);
+   }
+   /* Verticals */
+   for (i=12; i<36; i+=12) {
+      mvwaddch(pad, 0, i, ACS_TTEE);
+      mvwvline(pad, 1, i, ACS_VLINE, 17);
+      mvwaddch(pad, 18,i, ACS_BTEE);
+   }
 
-      /* Horizontal insides */
-      for (i=2; i<18; i+=2) {
-         if (i%6==0) continue;
-         mvwhline(grid, i, 1, '-', 35);
-      }
-      /* Vertical insides */
-      for (i=4; i<36; i+=4) {
-         if (i%12==0) continue;
-         mvwvline(grid, 1, i, '|', 17);
-      }
-      /* Verticals */
-      for (i=12; i<36; i+=12) {
-         mvwaddch(grid, 0, i, ACS_TTEE);
-         mvwvline(grid, 1, i, ACS_VLINE, 17);
-         mvwaddch(grid, 18,i, ACS_BTEE);
-      }
+   /* Horizontal */
+   for (i=6; i<18; i+=6) {
+      mvwaddch(pad, i, 0, ACS_LTEE);
+      mvwhline(pad, i, 1, ACS_HLINE, 36);
+      for (j=12; j<=36; j+=12)
+         mvwaddch(pad, i, j, ACS_PLUS);
+      mvwaddch(pad, i, 36, ACS_RTEE);
+   }
+   return pad;
+}
 
-      /* Horizontal */
-      for (i=6; i<18; i+=6) {
-         mvwaddch(grid, i, 0, ACS_LTEE);
-         mvwhline(grid, i, 1, ACS_HLINE, 36);
-         for (j=12; j<=36; j+=12)
-            mvwaddch(grid, i, j, ACS_PLUS);
-         mvwaddch(grid, i, 36, ACS_RTEE);
-      }
+/* Draw the grid's frame and every square. Only needed when the window
+ * has been cleared (a resize or unpause), changed squares are drawn by
+ * draw_grid_contents() */
+void draw_grid(struct board *b)
+{
+   WINDOW *pad;
+   int h, w;
+
+   if (!b->win) return;
+
+   if (is_paused() || !(pad = grid_frame())) {
+      werase(b->win);
+      box(b->win, 0, 0);
+      if (is_paused()) mvwaddstr(b->win, 9, 15, "Paused");
+   } else {
+      /* Copy the whole frame over, blanks included, so there's
+       * no need to erase first. The window may be cut down. */
+      getmaxyx(b->win, h, w);
+      copywin(pad, b->win, 0, 0, 0, 0, h-1, w-1, FALSE);
    }
 
-   wnoutrefresh(grid);
-   draw_grid_contents();
+   frame_refresh(b->win);
+   /* The window was redrawn, so every square needs drawing again */
+   board_touch_all(b);
+   draw_grid_contents(b);
 }
 
 
@@ -218,15 +265,17 @@ void draw_stats(void)
    box(stats, 0, 0);
    mvwprintw(stats, 1, 1, "Level:      %d/30", level);
    mvwprintw(stats, 2, 1, "Difficulty: %s", difficulties[difficulty-1]);
-   mvwprintw(stats, 4, 1, "Numbers:    %2d/81", grid_filled());
-   mvwprintw(stats, 5 ,1, "Remaining:  %2d left", 81-grid_filled());
-   mvwprintw(stats, 6 ,1, "Percent:    %-2.1f%%", ((double)grid_filled()/81)*100);
+   if (board.ntries)
+      mvwprintw(stats, 3, 1, "Trying:     %d deep", board.ntries);
+   mvwprintw(stats, 4, 1, "Numbers:    %2d/81", board.st.filled);
+   mvwprintw(stats, 5 ,1, "Remaining:  %2d left", 81-board.st.filled);
+   mvwprintw(stats, 6 ,1, "Percent:    %-2.1f%%", ((double)board.st.filled/81)*100);
    mvwprintw(stats, 8,1, "Time Taken: %dm %2ds", ltime.mins, ltime.secs);
    mvwprintw(stats, 9,1, "Game total: %dh %2dm", gtime.hours, gtime.mins);
    mvwhline(stats, 10, 1, ACS_HLINE, 23);
    mvwprintw(stats, 11,1, " Score:   %d", score);
 
-   wnoutrefresh(stats);
+   frame_refresh(stats);
 }
 
 void draw_intro(void)
@@ -251,26 +300,31 @@ void draw_intro(void)
    mvwaddstr(intro, 14, 1, " - Press 'H' to view high scores");
    mvwaddstr(intro, 17, 1, "   By Vincent Launchbury et. al. ");
 
-   wnoutrefresh(intro);
+   frame_refresh(intro);
 }
 
 static void draw_title(void)
 {
    werase(title);
    mvwaddstr(title, 0, 5, "Welcome to nsuds: The Ncurses Sudoku System");
-   wnoutrefresh(title);
+   frame_refresh(title);
 }
 
-/* Add highlighted string, using color if supported */
+/* Attribute for highlighting, using color if supported. Not
+ * worth the escape sequences on a slow link. */
+#define HL_ATTR (use_colors ? COLOR_PAIR(C_KEY) : \
+                 low_bandwidth ? A_NORMAL : A_UNDERLINE)
+
+/* Add highlighted string */
 #define waddhlstr(w, str)                                      \
    do {                                                        \
-      wattrset(w, (use_colors?COLOR_PAIR(C_KEY):A_UNDERLINE)); \
+      wattrset(w, HL_ATTR);                                    \
       waddstr(w, str);                                         \
       wattrset(w, 0);                                          \
    } while(0) 
 
-/* Add highlighted character, using color if supported */
-#define waddhlch(w,c) waddch(w, c | (use_colors?COLOR_PAIR(C_KEY):A_UNDERLINE))
+/* Add highlighted character */
+#define waddhlch(w,c) waddch(w, c | HL_ATTR)
 
 /* Draw function bar at bottom of screen
  * Always on the last line, full width */
@@ -303,7 +357,7 @@ static void draw_fbar(void)
    /* Help */
    waddstr(fbar, " Help:");
    waddhlstr(fbar, "?");
-   wnoutrefresh(fbar);
+   frame_refresh(fbar);
 
 }
 
@@ -311,20 +365,35 @@ void hide_fbar(void)
 {
    fbar_time=0;
    werase(fbar);
-   if (row <= 30) mvwhline(fbar, 0, 0, ACS_CKBOARD, col);
-   else mvwhline(fbar, 0, 0, ' ', col);
-   wrefresh(fbar);
+   mvwhline(fbar, 0, 0, BACKGROUND, col);
+   frame_refresh(fbar);
 }
 
-/* Higher level getch that converts ESC+key to the meta value */
+/* Dragging the corner of a terminal sends a storm of resizes. Swallow
+ * them until they stop coming, so whoever's reading keys only lays out
+ * the screen once, for the final size. */
+static void drain_resize(void)
+{
+   int c;
+
+   /* Through the event loop, so signals are still handled */
+   while ((c = frame_getch_timeout(RESIZE_SETTLE)) == KEY_RESIZE);
+   if (c != ERR) ungetch(c);
+   getmaxyx(stdscr, row, col);
+}
+
+/* Higher level getch that converts ESC+key to the meta value,
+ * and collapses a run of resizes into one KEY_RESIZE */
 int getkey(void)
 {
    int c;
-   while ((c=getch())) {
+   while ((c=frame_getch())) {
+      /* The benchmark's script has run out */
+      if (c == ERR && bench_running()) bench_finish();
       switch (c) {
          /* Escape (meta sequence) */
          case 27: 
-            while ((c=getch())) {
+            while ((c=frame_getch())) {
                switch (c) {
                   case 27: /* Escape */
                   case ERR:
@@ -336,6 +405,9 @@ int getkey(void)
          /* Don't return for this! */
          case ERR:
             continue;
+         case KEY_RESIZE:
+            drain_resize();
+            return c;
          /* Regular key, return */
          default:
             return c;
@@ -350,8 +422,7 @@ void unknown_key(void)
 {
    if (!fbar_time) {
       draw_fbar();
-      doupdate();
-      movec(CUR);
+      movec(&board, CUR);
       fbar_time = 5;
    }
 }
@@ -360,39 +431,35 @@ static void draw_xs(void)
 {
    int i;
    erase();
-   for (i=0; i<30; i++)
-      mvhline(i, 0, ACS_CKBOARD, 90);
-   wnoutrefresh(stdscr);
+   if (!low_bandwidth) {
+      for (i=0; i<30; i++)
+         mvhline(i, 0, ACS_CKBOARD, 90);
+   }
+   frame_refresh(stdscr);
 }
 
 void draw_all(void)
 {
+   trace_redraw();
    switch (dmode) {
       case INTRO:
-         delwin(intro);
-         intro = newwin(19, 37, 2, 28);
+         intro = place_window(intro, 19, 37, 2, 28);
          draw_xs();
          draw_title();
          draw_intro();
-         movec(CUR);
+         movec(&board, CUR);
          break;
       case IN_GAME:
-         /* We have to do this because otherwise, if any of the windows are too
-          * large for the screen, and then the screen is enlarged, ncurses
-          * messes up the heights. */
-         delwin(title);
-         delwin(grid);
-         delwin(timer);
-         delwin(stats);
-         delwin(fbar);
+         /* ncurses shrinks windows that don't fit when the screen gets
+          * smaller, but never grows them back, so put them all back to
+          * their proper sizes. */
          init_windows();
          draw_xs();
          draw_title();
          draw_timer();
-         draw_grid();
+         draw_grid(&board);
          draw_stats();
-         if (!scrl_open) doupdate();
-         if (!scrl_open) movec(CUR);
+         if (!scrl_open) movec(&board, CUR);
          break;
    }
 }
@@ -416,34 +483,43 @@ void new_game(void)
 /* Start a new level */
 void new_level(void)
 {
-   /* Clear all marks */
-   memset(marks, 0, sizeof(marks));
-   memset(showmarks, 0, 3);
+   char puzzle[9][9];
 
-   /* Start a new game */
-   generate();
+   /* Start a new game, clearing all marks */
+   generate(puzzle);
+   board_load(&board, puzzle);
    start_timer(level_times[difficulty-1][0], level_times[difficulty-1][1]);
+   autosave_snapshot();
+   game_pause(0);
+}
+
+/* Carry on with a game loaded by autosave_restore() */
+static void resume_game(void)
+{
+   dmode=IN_GAME;
+   resume_timer();
+   autosave_snapshot();
    game_pause(0);
 }
 
 /* Generate a puzzle */
-static void generate(void)
+static void generate(char puzzle[9][9])
 {
    switch (difficulty) {
       case EASY:
-         do_generate(38);
+         do_generate(puzzle, 38);
          break;
       case MEDIUM:
-         do_generate(32);
+         do_generate(puzzle, 32);
          break;
       case HARD:
-         do_generate(28);
+         do_generate(puzzle, 28);
          break;
       case EXPERT:
-         do_generate(26);
+         do_generate(puzzle, 26);
          break;
       case INSANE:
-         do_generate(18);
+         do_generate(puzzle, 18);
          break;
    }
 }
@@ -454,11 +530,14 @@ void game_pause(int action)
    switch (action) {
       case 1:
          paused=1;
+         timer_pause(1);
          curs_set(0);
          break;
-      /* Unpause */
+      /* Unpause, only once a game has started */
       case 0:
+         if (dmode != IN_GAME) break;
          paused=0;
+         timer_pause(0);
          curs_set(1);
          draw_all();
          break;
@@ -471,16 +550,28 @@ int is_paused(void)
    return paused;
 }
 
+/* Is a game being played (rather than choosing one)? */
+int is_playing(void)
+{
+   return dmode == IN_GAME;
+}
+
 int main(int argc, char **argv)
 {
    int c;
    int opt, opti;
+   char *trace_log=NULL;
+   int bench_rounds=0, bench_help=0;
    static struct option long_opts[] =
    {
       {"color",     optional_argument, 0, 'c'},
       {"no-color",  no_argument,       0, 'C'},
       {"help",      no_argument,       0, 'h'},
       {"version",   no_argument,       0, 'v'},
+      {"trace-render", optional_argument, 0, 'T'},
+      {"benchmark", optional_argument, 0, 'B'},
+      {"benchmark-help", optional_argument, 0, 'H'},
+      {"low-bandwidth", optional_argument, 0, 'L'},
       {0, 0, 0, 0}
    };
 
@@ -503,6 +594,30 @@ int main(int argc, char **argv)
          case 'C':
             colors_when = NEVER;
             break;
+         case 'T':
+            trace_log = optarg ? optarg : "nsuds-render.log";
+            break;
+         case 'L':
+            low_bandwidth = optarg ? atoi(optarg) : LOWBW_TIMER;
+            if (low_bandwidth < 1) {
+               fprintf(stderr, "Error: Invalid option to --low-bandwidth, "
+                  "`%s'\n", optarg);
+               exit(EXIT_FAILURE);
+            }
+            /* Unless asked for, colors cost too much */
+            if (colors_when == AUTO) colors_when = NEVER;
+            break;
+         case 'H':
+            bench_help=1;
+            /* Fall through */
+         case 'B':
+            bench_rounds = optarg ? atoi(optarg) : BENCH_ROUNDS;
+            if (bench_rounds < 1) {
+               fprintf(stderr, "Error: Invalid option to --%s, `%s'\n",
+                  long_opts[opti].name, optarg);
+               exit(EXIT_FAILURE);
+            }
+            break;
          case 'h':
            fputs("Usage: nsuds [OPTIONS]...\n\
 Nsuds: The Ncurses Sudoku System\n\
@@ -510,7 +625,26 @@ Nsuds: The Ncurses Sudoku System\n\
                        or `always'. Defaults to `auto' \n\
    -C --no-color     Synonym for --color=never\n\
    -h --help         Show this help screen\n\
-   -v --version      Print version info\n\
+   -v --version      Print version info\n",
+             stdout);
+           fputs("\
+   --low-bandwidth[=SECS]\n\
+                     Send as little as possible to the terminal, for slow\n\
+                       links. The timer is only updated every SECS (5)\n\
+                       seconds, and colors are off unless asked for\n",
+             stdout);
+           fputs("\
+   --trace-render[=FILE]\n\
+                     Count what drawing writes to the terminal, and write\n\
+                       a summary to FILE (nsuds-render.log) at exit\n\
+   --benchmark[=ROUNDS]\n\
+                     Play ROUNDS (20) rounds of a scripted game without a\n\
+                       terminal, and report the time and bytes it took\n",
+             stdout);
+           fputs("\
+   --benchmark-help[=ROUNDS]\n\
+                     Page through the help ROUNDS (20) times on a wide\n\
+                       screen, and report the time and bytes it took\n\
 Report bugs to <" PACKAGE_BUGREPORT ">\n\
 Home Page: http://www.sourceforge.net/projects/nsuds/\n",
              stdout);
@@ -526,13 +660,35 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
       }
    }
 
+   if (trace_log && !trace_init(trace_log))
+      errx(EXIT_FAILURE, "Can't trace rendering, the terminal must be "
+         "on stdout and stderr");
+   if (bench_rounds && !bench_start(bench_rounds, bench_help))
+      errx(EXIT_FAILURE, "Can't set up the benchmark's screen");
+
    /* Setup ncurses and windows */
    init_ncurses();
    init_windows();
    init_signals();
-
-   /* Start the game */
-   new_game();
+   /* Benchmarks don't touch the saved game */
+   if (!bench_running()) autosave_init(&board);
+
+   /* Offer to carry on with a game that was quit or interrupted */
+   if (autosave_exists()) {
+      start_timer(0,0);
+      draw_all();
+      if (confirm("Resume your saved game?") && autosave_restore()) {
+         resume_game();
+      } else {
+         /* Keep the blank timer stopped until a game is chosen */
+         game_pause(1);
+         autosave_discard();
+         new_game();
+      }
+   } else {
+      /* Start the game */
+      new_game();
+   }
    
    /* Main input loop */
    while ((c = getkey())) {
@@ -541,13 +697,13 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
          case 'h':
          case 'a':
          case CTRL('b'):
-            movec(LEFT);
+            movec(&board, LEFT);
             break;
          case KEY_RIGHT:
          case 'l':
          case 'd':
          case CTRL('f'):
-            movec(RIGHT);
+            movec(&board, RIGHT);
             break;
          case KEY_UP:
          case 'k':
@@ -555,7 +711,7 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
          case CTRL('u'):
          case CTRL('y'):
          case CTRL('p'):
-            movec(UP);
+            movec(&board, UP);
             break;
          case KEY_DOWN:
          case 'j':
@@ -563,31 +719,32 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
          case CTRL('d'):
          case CTRL('e'):
          case CTRL('n'):
-            movec(DOWN);
+            movec(&board, DOWN);
             break;
          /* Move between sub-grids */
          case CTRL('j'):
          case ALT('n'):
          case CTRL('v'):
-            movec(SUB_DOWN);
+            movec(&board, SUB_DOWN);
             break;
          case KEY_BACKSPACE: /* C-h is often sent as backspace */
          case CTRL('h'):
          case ALT('b'):
-            movec(SUB_LEFT);
+            movec(&board, SUB_LEFT);
             break;
          case CTRL('k'):
          case ALT('p'):
          case ALT('v'):
-            movec(SUB_UP);
+            movec(&board, SUB_UP);
             break;
          case CTRL('l'):
          case ALT('f'):
-            movec(SUB_RIGHT);
+            movec(&board, SUB_RIGHT);
             break;
          case 'Q':
          case 'q':
             if (confirm("Really quit?")) {
+               autosave_snapshot();
                endwin();
                goto done;
             }
@@ -597,12 +754,11 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
          case '?':
             if (!is_paused())  {
                game_pause(1);
-               draw_grid();
-               doupdate();
-               movec(CUR);
+               draw_grid(&board);
+               movec(&board, CUR);
             }
             scrl_open=1;
-            launch_file(HELPDIR "main", "Help with nsuds");
+            launch_help("main", "Help with nsuds");
             scrl_open=0;
             game_pause(0);
             break;
@@ -610,31 +766,40 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
          case 'H':
             if (!is_paused())  {
                game_pause(1);
-               draw_grid();
-               doupdate();
-               movec(CUR);
+               draw_grid(&board);
+               movec(&board, CUR);
             }
             scrl_open=1;
             display_scores();
             scrl_open=0;
             game_pause(0);
             break;
+         /* History of finished games */
+         case 'L':
+            if (!is_paused())  {
+               game_pause(1);
+               draw_grid(&board);
+               movec(&board, CUR);
+            }
+            scrl_open=1;
+            display_history();
+            scrl_open=0;
+            game_pause(0);
+            break;
          case 'P':
          case 'p':
             paused=!paused;
-            draw_grid();
-            doupdate();
+            timer_pause(paused);
+            draw_grid(&board);
             curs_set(!paused);
-            movec(CUR);
+            movec(&board, CUR);
             break;
          case 'x':
          case '0':
          case KEY_DC:
-            gsetcur(0);
-            draw_grid();
-            draw_stats();
-            doupdate();
-            movec(CUR);
+            gsetcur(&board, 0);
+            frame_dirty(FRAME_STATS);
+            movec(&board, CUR);
             break;
          /* New game, in freeplay */
          case 'n':
@@ -646,19 +811,33 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
 
          /* Marking Tools */
          case 'm':
-            mark_square();
+            mark_square(&board);
             break;
          case 'r':
-            marks_show(ONE);
+            marks_show(&board, ONE);
             break;
          case 'R':
-            marks_show(MULTIPLE);
+            marks_show(&board, MULTIPLE);
             break;
          case 'c':
-            marks_clear(SINGLE);
+            marks_clear(&board, SINGLE);
             break;
          case 'C':
-            marks_clear(ALL);
+            marks_clear(&board, ALL);
+            break;
+
+         /* Trying out a guess */
+         case 't':
+            try_begin(&board);
+            movec(&board, CUR);
+            break;
+         case 'u':
+            try_rollback(&board);
+            movec(&board, CUR);
+            break;
+         case 'T':
+            try_commit(&board);
+            movec(&board, CUR);
             break;
 #ifdef DEBUG
          /* Very useful for debugging */
@@ -679,25 +858,22 @@ Send bug reports to <" PACKAGE_BUGREPORT ">\n",
             if (getmouse(&mouse_e) == OK) {
                /* Left click selects square */
                if (mouse_e.bstate & BUTTON1_CLICKED) {
-                  movec_mouse(mouse_e.x, mouse_e.y);
+                  movec_mouse(&board, mouse_e.x, mouse_e.y);
                }
             }
             break;
          case KEY_RESIZE:
-            getmaxyx(stdscr, row, col);
             fbar_time=0;
-            delwin(fbar);
-            fbar = newwin(1, col, row-1, 0);
+            fbar = place_window(fbar, 1, col, row-1, 0);
             draw_all();
             break;
          default:
             /* Handle number input */
             if (c>='1' && c<='9') {
                if (!is_paused()) {
-                  gsetcur(c-'0');
-                  draw_stats();
-                  doupdate();
-                  movec(CUR);
+                  gsetcur(&board, c-'0');
+                  frame_dirty(FRAME_STATS);
+                  movec(&board, CUR);
                }
             /* Key unknown, show function bar */
             } else {
@@ -20,25 +20,30 @@
 #ifndef _NSUDS_NSUDS_H
 #define _NSUDS_NSUDS_H
 
-extern WINDOW *grid, *timer, *stats, *title, *fbar;
+extern WINDOW *timer, *stats, *title, *fbar;
+extern struct board board;
 extern int difficulty;
+extern char *difficulties[];
 extern char level_times[][2]; 
 extern int score;
 extern int fbar_time;
 extern int row,col;
 extern int use_colors;
+extern int low_bandwidth;
 extern int scrl_open;
 extern void game_over(void);
 extern void game_win(void);
 extern void draw_stats(void);
-extern void draw_grid(void);
+extern void draw_grid(struct board *b);
 extern void draw_all(void);
 extern void hide_fbar(void);
 extern void new_level(void);
 extern void new_game(void);
 extern void unknown_key(void);
 extern int getkey(void);
+extern void catch_signal(int sig);
 int is_paused(void);
+int is_playing(void);
 void game_pause(int action);
 
 enum {
@@ -48,6 +53,15 @@ enum {
 };
 enum {EASY=1, MEDIUM, HARD, EXPERT, INSANE};
 
+/* Character filling the background. The checkerboard only fits on
+ * small screens, and is expensive to send over slow links. */
+#define BACKGROUND ((row <= 30 && !low_bandwidth) ? ACS_CKBOARD : ' ')
+/* Seconds between timer updates with --low-bandwidth, if not given */
+#define LOWBW_TIMER 5
+
+/* Milliseconds to wait for more resizes before redrawing */
+#define RESIZE_SETTLE 50
+
 #define CTRL(key) 1+key-'a'
 #define ALT(key) 225+key-'a'
 #define CTRL_ALT(key) 129+key-'a'
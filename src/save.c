@@ -0,0 +1,384 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+
+/* save.c
+ * ------
+ * Crash-safe autosave. Every move is appended to a small journal as a
+ * one-line record. Records are batched in memory and written out every
+ * few seconds, and fsync() is rate limited, so a keypress never costs a
+ * disk write. Once the journal grows long enough, it's compacted into a
+ * full snapshot of the game. A saved game is the snapshot with the
+ * journal replayed over the top of it. */
+#include "config.h"
+
+#define _XOPEN_SOURCE 500
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#if STDC_HEADERS || HAVE_STRING_H
+   #include <string.h>
+#else /* Old system with only <strings.h> */
+   #include <strings.h>
+#endif
+#ifdef HAVE_NCURSES_H
+   #include <ncurses.h>
+#else
+   #include <curses.h>
+#endif
+
+#include "nsuds.h"
+#include "board.h"
+#include "save.h"
+#include "timer.h"
+#include "score.h"
+#include "util.h"
+
+#define SAVE_MAGIC "nsuds-save 1"
+#define SAVE_LEVELS 30 /* Levels in a game */
+
+static struct board *saved;  /* Board being saved */
+static char *snap_name;    /* Snapshot file */
+static char *snap_tmp;     /* Snapshot is written here, then renamed */
+static char *jrnl_name;    /* Journal file */
+static int jfd=-1;         /* Open journal, or -1 */
+static int active=0;       /* Is there a game being saved? */
+
+static char jbuf[1024];    /* Batched records not yet written */
+static int jlen=0;
+static int records=0;      /* Records in the journal since the snapshot */
+static time_t batch_start; /* When the oldest unwritten record was added */
+static time_t last_sync;   /* Last time the journal was fsync'ed */
+static int sync_pending=0; /* Written, but not yet synced */
+
+static void jrnl_add(char *fmt, ...);
+static void jrnl_write(void);
+static void jrnl_sync(void);
+static char *save_path(char *home, char *name);
+
+/* Set up autosave for a board, and work out where to keep the save
+ * files. Autosave is silently disabled if there's no home directory. */
+void autosave_init(struct board *b)
+{
+   char *home = getenv("HOME");
+   saved = b;
+   if (!home || !*home) return;
+
+   snap_name = save_path(home, "/.nsuds_save");
+   snap_tmp  = save_path(home, "/.nsuds_save.tmp");
+   jrnl_name = save_path(home, "/.nsuds_journal");
+}
+
+static char *save_path(char *home, char *name)
+{
+   char *path = tmalloc(strlen(home) + strlen(name) + 1);
+   strcpy(path, home);
+   strcat(path, name);
+   return path;
+}
+
+/* Is there a saved game to resume? */
+int autosave_exists(void)
+{
+   return snap_name && access(snap_name, R_OK) == 0;
+}
+
+/* Write a full snapshot of the game, and start a fresh journal */
+void autosave_snapshot(void)
+{
+   FILE *fd;
+   struct level *l;
+   int i, j;
+
+   if (!snap_name || !saved) return;
+
+   fd = fopen(snap_tmp, "w");
+   if (fd == NULL) return;
+
+   fprintf(fd, "%s\n", SAVE_MAGIC);
+   fprintf(fd, "%d %d %d\n", difficulty, level, score);
+   timer_played(); /* Bring the times up to date */
+   fprintf(fd, "%d %d %d %d %d %d %d\n", cdown.mins, cdown.secs,
+      ltime.mins, ltime.secs, gtime.hours, gtime.mins, gtime.secs);
+   /* Givens are stored negated */
+   for (i=0; i<9; i++) {
+      for (j=0; j<9; j++) {
+         fprintf(fd, "%d ", board_given(saved, i, j) ? -saved->st.cells[i][j]
+                                                     : saved->st.cells[i][j]);
+      }
+      fputc('\n', fd);
+   }
+   for (i=0; i<9; i++) {
+      for (j=0; j<9; j++)
+         fprintf(fd, "%d ", saved->st.marks[i][j]);
+      fputc('\n', fd);
+   }
+   TAILQ_FOREACH(l, &level_data, entries) {
+      fprintf(fd, "l %d %d %d %d\n", l->level, l->time.mins,
+         l->time.secs, l->score);
+   }
+
+   if (fflush(fd) || fsync(fileno(fd))) {
+      fclose(fd);
+      unlink(snap_tmp);
+      return;
+   }
+   fclose(fd);
+   if (rename(snap_tmp, snap_name) == -1) return;
+
+   /* The snapshot now covers everything in the journal */
+   jlen=0;
+   records=0;
+   sync_pending=0;
+   if (jfd != -1) close(jfd);
+   jfd = open(jrnl_name, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+   last_sync = time(NULL);
+   active=1;
+}
+
+/* The game has ended, there's nothing to resume any more */
+void autosave_discard(void)
+{
+   active=0;
+   jlen=0;
+   records=0;
+   if (jfd != -1) close(jfd);
+   jfd=-1;
+
+   if (!snap_name) return;
+   unlink(snap_name);
+   unlink(jrnl_name);
+}
+
+/* Load the saved game into the board, timers and score. Everything is
+ * read and checked first, and only used once the whole save has parsed,
+ * so a bad save leaves the game as it was. Returns 0 if there's nothing
+ * usable to load. */
+int autosave_restore(void)
+{
+   FILE *fd;
+   char magic[32];
+   int i, j, n, v, y, x;
+   int diff, lev, sc;
+   int lvls[SAVE_LEVELS][4], nlvls=0;
+   int t[7];
+   char type;
+   char puzzle[9][9];
+   unsigned short marks[9][9];
+
+   if (!autosave_exists() || !saved) return 0;
+   fd = fopen(snap_name, "r");
+   if (fd == NULL) return 0;
+
+   if (!fgets(magic, sizeof(magic), fd) ||
+         strncmp(magic, SAVE_MAGIC, strlen(SAVE_MAGIC)) ||
+         fscanf(fd, "%d %d %d", &diff, &lev, &sc) != 3 ||
+         diff < EASY || diff > INSANE || lev < 1 || lev > SAVE_LEVELS ||
+         fscanf(fd, "%d %d %d %d %d %d %d", &t[0], &t[1], &t[2], &t[3],
+            &t[4], &t[5], &t[6]) != 7) goto bad;
+   for (i=0; i<9; i++) {
+      for (j=0; j<9; j++) {
+         if (fscanf(fd, "%d", &v) != 1 || v < -9 || v > 9) goto bad;
+         puzzle[i][j] = v;
+      }
+   }
+   for (i=0; i<9; i++) {
+      for (j=0; j<9; j++) {
+         /* Only marks 1-9 */
+         if (fscanf(fd, "%d", &v) != 1 || v & ~0x3fe) goto bad;
+         marks[i][j] = v;
+      }
+   }
+   while (fscanf(fd, " l %d %d %d %d", &lvls[nlvls][0], &lvls[nlvls][1],
+         &lvls[nlvls][2], &lvls[nlvls][3]) == 4) {
+      if (++nlvls == SAVE_LEVELS) break;
+   }
+   fclose(fd);
+
+   /* Replay the journal over the snapshot. A torn record at the
+    * end (from a crash mid-write) just stops the replay. Givens
+    * can't be changed. */
+   fd = fopen(jrnl_name, "r");
+   if (fd != NULL) {
+      while (fscanf(fd, " %c", &type) == 1) {
+         switch (type) {
+            case 's':
+               if (fscanf(fd, "%d %d %d", &y, &x, &v) != 3) goto replayed;
+               if (y<0 || y>8 || x<0 || x>8 || v<0 || v>9) break;
+               if (puzzle[y][x] >= 0) puzzle[y][x] = v;
+               break;
+            case 'm':
+            case 'u':
+               if (fscanf(fd, "%d %d %d", &y, &x, &n) != 3) goto replayed;
+               if (y<0 || y>8 || x<0 || x>8 || n<1 || n>9) break;
+               if (type == 'm') marks[y][x] |= MARK(n);
+               else marks[y][x] &= ~MARK(n);
+               break;
+            case 'c':
+               if (fscanf(fd, "%d", &n) != 1) goto replayed;
+               if (n<1 || n>9) break;
+               for (i=0; i<9; i++)
+                  for (j=0; j<9; j++) marks[i][j] &= ~MARK(n);
+               break;
+            case 't':
+               if (fscanf(fd, "%d %d %d %d %d %d %d", &t[0], &t[1], &t[2],
+                     &t[3], &t[4], &t[5], &t[6]) != 7) goto replayed;
+               break;
+            default:
+               goto replayed;
+         }
+      }
+replayed:
+      fclose(fd);
+   }
+   for (i=0; i<7; i++) {
+      if (t[i] < 0) return 0;
+   }
+
+   /* It's all good, use it */
+   difficulty = diff;
+   level = lev;
+   score = sc;
+   board_load(saved, puzzle);
+   memcpy(saved->st.marks, marks, sizeof(marks));
+   board_rehash(saved);
+   init_level_data();
+   for (i=0; i<nlvls; i++)
+      add_level_data(lvls[i][0], lvls[i][1], lvls[i][2], lvls[i][3]);
+   cdown.mins = t[0]; cdown.secs = t[1];
+   ltime.mins = t[2]; ltime.secs = t[3];
+   gtime.hours = t[4]; gtime.mins = t[5]; gtime.secs = t[6];
+   return 1;
+
+bad:
+   fclose(fd);
+   return 0;
+}
+
+/* Journal a number being put in (or removed from) a square */
+void autosave_cell(int y, int x, int val)
+{
+   jrnl_add("s %d %d %d\n", y, x, val);
+}
+
+/* Journal a pencil mark being set or cleared */
+void autosave_mark(int y, int x, int num, int set)
+{
+   jrnl_add("%c %d %d %d\n", set ? 'm' : 'u', y, x, num);
+}
+
+/* Journal all marks for a number being cleared */
+void autosave_clear_marks(int num)
+{
+   jrnl_add("c %d\n", num);
+}
+
+/* Called when autosave_wait() says it's time. Writes out a batch of
+ * records once it's old enough, and catches up on any fsync that was
+ * rate limited. */
+void autosave_tick(void)
+{
+   if (!active) return;
+   if (jlen && time(NULL) - batch_start >= AUTOSAVE_FLUSH) {
+      jrnl_write();
+   }
+   if (sync_pending) jrnl_sync();
+}
+
+/* Milliseconds until autosave_tick() has something to do, 0 if it
+ * does now, or -1 if there's nothing waiting to be written or synced */
+long autosave_wait(void)
+{
+   time_t now, due=0;
+
+   if (!active || jfd == -1) return -1;
+   if (jlen) due = batch_start + AUTOSAVE_FLUSH;
+   if (sync_pending && (!due || last_sync + AUTOSAVE_SYNC < due))
+      due = last_sync + AUTOSAVE_SYNC;
+   if (!due) return -1;
+   now = time(NULL);
+   return due > now ? (due - now) * 1000L : 0;
+}
+
+/* Get everything we have onto the disk. Only uses async-signal-safe
+ * calls, so it's safe from a fatal signal handler. */
+void autosave_emergency(void)
+{
+   if (!active || jfd == -1) return;
+   if (jlen) write(jfd, jbuf, jlen);
+   jlen=0;
+   fsync(jfd);
+}
+
+/* Add a record to the current batch. Called after the move has been
+ * made, so if it's time to compact, the snapshot already includes it. */
+static void jrnl_add(char *fmt, ...)
+{
+   va_list ap;
+   char rec[64];
+   int n;
+
+   if (!active) return;
+
+   if (records >= AUTOSAVE_COMPACT) {
+      autosave_snapshot();
+      return;
+   }
+
+   va_start(ap, fmt);
+   n = vsprintf(rec, fmt, ap);
+   va_end(ap);
+
+   /* Leave room for the timer record added by jrnl_write() */
+   if (jlen + n + 64 > (int)sizeof(jbuf)) jrnl_write();
+   if (!jlen) batch_start = time(NULL);
+   memcpy(jbuf + jlen, rec, n);
+   jlen += n;
+   records++;
+}
+
+/* Write out the current batch. The timers are journalled with
+ * each batch, so a resumed game loses very little time. */
+static void jrnl_write(void)
+{
+   if (jfd == -1 || !jlen) return;
+   timer_played(); /* Bring the times up to date */
+   jlen += sprintf(jbuf + jlen, "t %d %d %d %d %d %d %d\n", cdown.mins,
+      cdown.secs, ltime.mins, ltime.secs, gtime.hours, gtime.mins,
+      gtime.secs);
+   if (write(jfd, jbuf, jlen) == jlen) {
+      sync_pending=1;
+      jrnl_sync();
+   }
+   jlen=0;
+}
+
+/* fsync the journal, but no more than every AUTOSAVE_SYNC seconds */
+static void jrnl_sync(void)
+{
+   time_t now = time(NULL);
+   if (jfd == -1 || now - last_sync < AUTOSAVE_SYNC) return;
+   fsync(jfd);
+   last_sync = now;
+   sync_pending=0;
+}
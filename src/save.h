@@ -0,0 +1,42 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+#ifndef _NSUDS_SAVE_H
+#define _NSUDS_SAVE_H
+
+/* Seconds a batch of journal records may wait before being written */
+#define AUTOSAVE_FLUSH   3
+/* Minimum seconds between two fsync()s of the journal */
+#define AUTOSAVE_SYNC    10
+/* Journal records written before it's compacted into a snapshot */
+#define AUTOSAVE_COMPACT 256
+
+extern void autosave_init(struct board *b);
+extern int autosave_exists(void);
+extern int autosave_restore(void);
+extern void autosave_snapshot(void);
+extern void autosave_discard(void);
+extern void autosave_cell(int y, int x, int val);
+extern void autosave_mark(int y, int x, int num, int set);
+extern void autosave_clear_marks(int num);
+extern long autosave_wait(void);
+extern void autosave_tick(void);
+extern void autosave_emergency(void);
+
+#endif
@@ -33,13 +33,17 @@
    #include <curses.h>
 #endif
 #include <math.h>
+#include <time.h>
 
 #include "score.h"
 #include "nsuds.h"
+#include "board.h"
 #include "timer.h"
 #include "util.h"
 #include "grid.h"
 #include "scroller.h"
+#include "save.h"
+#include "bench.h"
 
 int score=0;
 int level=1;
@@ -48,6 +52,8 @@ static char *rasline;   /* For rasprintf */
 
 static char *rasprintf(char *format, ...);
 static void free_ras(void);
+static char *history_path(void);
+static void log_game(void);
 
 /* Allocate string and parse with vsprintf, then return the allocated string,
  * for use with scroller_write. Note that if the formatting characters
@@ -75,6 +81,26 @@ static void free_ras(void)
    }
 }
 
+/* Make sure the level data tail queue is initialized */
+void init_level_data(void)
+{
+   if (!initialized) {
+      TAILQ_INIT(&level_data);
+      initialized=1;
+   }
+}
+
+/* Add a finished level to the score breakdown */
+void add_level_data(int lev, int mins, int secs, int lscore)
+{
+   struct level *l = tmalloc(sizeof(struct level));
+   l->level = lev;
+   l->time.mins = mins;
+   l->time.secs = secs;
+   l->score = lscore;
+   TAILQ_INSERT_TAIL(&level_data, l, entries);
+}
+
 /* Display the level win screen. The game may end, or they
  * may be taken to a new level. */
 void game_win(void)
@@ -82,13 +108,8 @@ void game_win(void)
    Scroller *s;
    struct level *curlev, *i;  /* Current level data (and temp) */
    int cscore=0;              /* Cumulative score */
-   int origtime;              /* Original time given for level */
 
-   /* Make sure the tail queue is initialized */
-   if (!initialized) {
-      TAILQ_INIT(&level_data);
-      initialized=1;
-   }
+   init_level_data();
    /* Pause */
    game_pause(1);
    scrl_open=1;
@@ -100,7 +121,7 @@ void game_win(void)
    curlev = tmalloc(sizeof(struct level));
    curlev->level = level;
    /* Calculate score */
-   curlev->score = pow(800 + cdown.mins * 60 + cdown.secs, 1.7) / 1000;
+   curlev->score = pow(800 + timer_left() / 1000.0, 1.7) / 1000;
    switch (difficulty) {
       case EASY:
       case MEDIUM:
@@ -115,11 +136,9 @@ void game_win(void)
          break;
    }
    
-   /* Original time given for level (in seconds) */
-   origtime=level_times[difficulty-1][0] * 60 + 
-         level_times[difficulty-1][1];
-   curlev->time.mins = (origtime - (cdown.mins * 60 + cdown.secs)) / 60;
-   curlev->time.secs = (origtime - (cdown.mins * 60 + cdown.secs)) % 60;
+   /* Time taken for the level */
+   curlev->time.mins = timer_played() / 60000;
+   curlev->time.secs = timer_played() / 1000 % 60;
    TAILQ_INSERT_TAIL(&level_data, curlev, entries);
    score += curlev->score;
 
@@ -165,7 +184,7 @@ void game_win(void)
    scroller_set(s, SCRL_RFRESH, 1);
 
    /* Place over everything */
-   overwrite(s->window, grid);
+   overwrite(s->window, board.win);
 
    /* Handle user input */
    scroller_input_loop(s);
@@ -247,13 +266,17 @@ void game_over(void)
       free(i);
    }
 
+   /* Nothing left to resume */
+   autosave_discard();
+   log_game();
+
    /* TODO: Show high scores after */
 
    /* Allow draws again (and draw) */
    scroller_set(s, SCRL_RFRESH, 1);
 
    /* Place over everything */
-   overwrite(s->window, grid);
+   overwrite(s->window, board.win);
 
    /* Handle user input */
    scroller_input_loop(s);
@@ -264,9 +287,53 @@ void game_over(void)
    /* Reset score and timers */
    score = 0;
    level=1;
-   gtime.hours = gtime.mins = 0;
+   reset_game_timer();
 
    new_game();
    scrl_open=0;
 }
 
+
+/* Where the history of finished games is kept, or NULL if there's
+ * no home directory */
+static char *history_path(void)
+{
+   static char *path;
+   char *home = getenv("HOME");
+
+   if (!path && home && *home) {
+      path = tmalloc(strlen(home) + sizeof("/.nsuds_history"));
+      strcpy(path, home);
+      strcat(path, "/.nsuds_history");
+   }
+   return path;
+}
+
+/* Add a line for the game that just ended to the history */
+static void log_game(void)
+{
+   FILE *fd;
+   char date[32];
+   time_t now = time(NULL);
+
+   if (bench_running() || !history_path()) return;
+   fd = fopen(history_path(), "a");
+   if (fd == NULL) return;
+   strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&now));
+   fprintf(fd, "%s  %-6s  Level %2d  Score %6d  %2d:%02d:%02d\n", date,
+      difficulties[difficulty-1], level, score,
+      gtime.hours, gtime.mins, gtime.secs);
+   fclose(fd);
+}
+
+/* Show the history of finished games, which can grow long */
+void display_history(void)
+{
+   FILE *fd;
+
+   if (!history_path()) return;
+   /* Create it if no game has finished yet, so it shows as empty */
+   fd = fopen(history_path(), "a");
+   if (fd) fclose(fd);
+   launch_file(history_path(), "Game History");
+}
@@ -25,6 +25,9 @@
 /* Headers */
 extern void game_win(void);
 extern void game_over(void);
+extern void display_history(void);
+extern void init_level_data(void);
+extern void add_level_data(int lev, int mins, int secs, int lscore);
 
 extern int score;
 extern int level;
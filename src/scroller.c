@@ -19,6 +19,8 @@
  */
 #include "config.h"
 
+#define _XOPEN_SOURCE 500
+
 #include <stdio.h>
 #if STDC_HEADERS || HAVE_STRING_H
    #include <string.h>
@@ -26,27 +28,57 @@
    #include <strings.h>
 #endif
 #include <stdlib.h>
+#include <limits.h>
 #ifdef HAVE_NCURSES_H
    #include <ncurses.h>
 #else 
    #include <curses.h>
 #endif
-#include <math.h>
+#include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/queue.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
 
 #include "nsuds.h"
+#include "board.h"
 #include "util.h"
 #include "scroller.h"
+#include "markup.h"
+#include "help.h"
+#include "frame.h"
 
 /* Headers */
+static int line_wraps(Scroller *s, int n);
+static int line_start(Scroller *s, int n);
+static int count_below(Scroller *s, int max);
+static int scroller_pos(Scroller *s);
 static bool scroller_can_down(Scroller *s);
-static void scroller_check_over(Scroller *s);
 static void scroller_scroll(Scroller *s, int dir);
+static void scroller_down(Scroller *s, int n);
+static void scroller_up(Scroller *s, int n);
+static void scroller_bottom(Scroller *s);
+static int known_lines(Scroller *s);
+static void scroller_jump(Scroller *s, int sl);
 static void scroller_resize(Scroller *s, int height, int width, 
             int starty, int startx);
 static void draw_scroller(Scroller *s);
+static void draw_line(Scroller *s, struct scrl_line *l, int start, int n);
+static long arena_alloc(Scroller *s, long n);
+static struct scrl_line *new_line(Scroller *s);
+static void count_line(Scroller *s, struct scrl_line *l);
+static void add_line(Scroller *s, char *msg, long n);
+static void scroller_load(Scroller *s, const struct helpfile *h);
+static int scroller_index(Scroller *s, long n);
+static int index_idle(void *arg);
+static void file_error(Scroller *s, char *what);
+static int scroller_prompt(Scroller *s);
+static void set_pattern(Scroller *s, char *pat);
+static int find_text(Scroller *s, struct scrl_line *l, int from);
+static int find_last(Scroller *s, struct scrl_line *l, int upto);
+static bool match_shown(Scroller *s);
+static int scroller_search(Scroller *s, int back);
 
 /* Return a pointer to a new scroller, or scrollable text window */
 Scroller *scroller_new(int height, int width, int starty, 
@@ -61,15 +93,30 @@ Scroller *scroller_new(int height, int width, int starty,
    new->size = 0;
    new->overview=0;
    new->tlines=0;
-   new->cur_sl=0;
-   new->cur=NULL;
+   new->cur=0;
+   new->line = tmalloc(sizeof(struct scrl_line) * SCRL_LINES);
+   new->alloc = SCRL_LINES;
+   new->wrapped = 0;
+   new->hist = tmalloc(sizeof(int) * SCRL_HIST);
+   new->hist_size = SCRL_HIST;
+   memset(new->hist, 0, sizeof(int) * SCRL_HIST);
+   new->arena = tmalloc(SCRL_ARENA);
+   new->used = 0;
+   new->arena_size = SCRL_ARENA;
+   new->map = NULL;
+   new->map_len = 0;
+   new->map_pos = 0;
+   new->pat = NULL;
+   new->plen = 0;
+   new->mline = -1;
+   new->msg = NULL;
+   new->cells = tmalloc(sizeof(chtype) * width);
    if (title) {
       new->title = tmalloc(strlen(title) + 1);
       strcpy(new->title, title);
    } else {
       new->title = NULL;
    }
-   TAILQ_INIT(&new->buffer);
 
    return new;
 }
@@ -77,7 +124,7 @@ Scroller *scroller_new(int height, int width, int starty,
 /* Redraw the window, after a scroll for instance */
 static void draw_scroller(Scroller *s)
 {
-   int i, j; 
+   int i, n;
    struct scrl_line *l;
    int dlines=0;                 /* Number of lines displayed */
 
@@ -95,29 +142,28 @@ static void draw_scroller(Scroller *s)
    }
 
    /* Loop through real lines in the buffer */
-   for (l=s->cur; l; l=TAILQ_NEXT(l, entries)) {
+   for (n=s->cur; n < s->size; n++) {
+      l = &s->line[n];
       /* Loop through segments that can fit within the width of the scroller */
-      for (i=0; i < l->lines; i++) {
-         int start = i * (s->width-2); /* Start of segment */
+      for (i=0; i < line_wraps(s, n); i++) {
          if (!dlines && i < s->overview) continue;  /* Skip overflowed lines */
          
          wmove(s->window, ++dlines, 1);
-         /* Print each character, adding formatting info */
-         for (j=start; j < l->len && j < s->width-2 + start; j++) {
-                     waddch(s->window, l->line[j] | l->fmask[j]);
-         }
+         draw_line(s, l, i * (s->width-2), s->width-2);
          if (dlines >= s->height-2) goto scrollbar;
       }
    }
 
 scrollbar:
 
+   if (s->msg) mvwaddnstr(s->window, s->height-1, 1, s->msg, s->width-2);
+
    /* Print a rather ugly scrollbar. Idealy it would take advantage of 256
     * color capabilities, but it requires ncurses to have the support
     * compiled in, and I'm not sure how widespread that is.. */
    if (s->tlines - 1 >= screen_space) {
       /* Start of scrollbar */
-      sbar_start  = ((double)(s->cur_sl+1) / s->tlines) * screen_space;
+      sbar_start  = ((double)(scroller_pos(s)+1) / s->tlines) * screen_space;
       sbar_start = clamp(sbar_start, 0, screen_space-1);
       /* And it's height */
       sbar_height = (((double)screen_space / s->tlines) * screen_space);
@@ -135,273 +181,665 @@ scrollbar:
    }
 
    /* And output it */
-   wrefresh(s->window);
+   frame_refresh(s->window);
 }
 
-/* Is there enough lines to scroll down? */
-static bool scroller_can_down(Scroller *s)
+/* Draw n characters of a line, from start, with their formatting. The
+ * characters and attributes are put together in s->cells, and written
+ * with one waddchnstr(), rather than a waddch() each. */
+static void draw_line(Scroller *s, struct scrl_line *l, int start, int n)
+{
+   unsigned char *text = (unsigned char *)s->arena + l->text;
+   unsigned char *run = (unsigned char *)s->arena + l->runs;
+   chtype *cell = s->cells;
+   int r, i, pos=0, end;
+   int m=-1; /* Match covering (or after) the character being drawn */
+   attr_t a;
+
+   if (start + n > l->len) n = l->len - start;
+   if (s->pat) m = find_text(s, l, start > s->plen ? start - s->plen + 1 : 0);
+   for (r=0; r < l->nruns && pos < start + n; r++, run += 2) {
+      end = pos + run[1];
+      if (end > start) {
+         /* Red OR cyan, either can be underlined */
+         a = 0;
+         if (run[0] & SCRL_KEY) a |= COLOR_PAIR(C_KEY);
+         if (run[0] & SCRL_URGENT) a |= COLOR_PAIR(C_URGENT) | A_BOLD;
+         if (run[0] & SCRL_UL) a |= A_UNDERLINE;
+         for (i = pos > start ? pos : start; i < end && i < start + n; i++) {
+            /* waddchnstr() doesn't handle control characters */
+            *cell = text[i] < ' ' || text[i] == 127 ? ' ' | a : text[i] | a;
+            while (m != -1 && m + s->plen <= i) m = find_text(s, l, m + 1);
+            /* Search matches are highlighted */
+            if (m != -1 && m <= i) *cell |= A_REVERSE;
+            cell++;
+         }
+      }
+      pos = end;
+   }
+   if (cell > s->cells) waddchnstr(s->window, s->cells, cell - s->cells);
+}
+
+/* Number of screen lines line n takes up. This is only worked out
+ * when it's needed, so a resize doesn't go through every line. */
+static int line_wraps(Scroller *s, int n)
 {
-   struct scrl_line *a;
-   int total= - s->overview-1;
-   for (a=s->cur; a; a=TAILQ_NEXT(a, entries)) {
-      total += a->lines;
-      if (total >= s->height-2) return true;
+   struct scrl_line *l = &s->line[n];
+
+   if (l->width != s->width) {
+      l->lines = (l->len + SCRL_TEXTW(s) - 1) / SCRL_TEXTW(s);
+      l->width = s->width;
    }
-   return false;
+   return l->lines;
 }
 
-/* Check if the scroller is scrolled too far due to a 
- * window resize. If so, fix it */
-static void scroller_check_over(Scroller *s)
+/* Screen line that line n starts on. The starts are summed from
+ * the top as far as they're needed, and kept until the width changes. */
+static int line_start(Scroller *s, int n)
 {
-   struct scrl_line *a;
-   int total= - s->overview-1;
-   for (a=s->cur; a; a=TAILQ_NEXT(a, entries)) {
-      total += a->lines;
-      if (total >= s->height-2) return;
+   struct scrl_line *l;
+
+   for (; s->wrapped <= n; s->wrapped++) {
+      l = &s->line[s->wrapped];
+      l->start = s->wrapped ? l[-1].start + line_wraps(s, s->wrapped - 1) : 0;
    }
-   /* Scroll to the bottom to fix issue */
-   if (total < s->height-1) scroller_scroll(s, SCROLL_BASE);
+   return s->line[n].start;
+}
+
+/* Screen lines from the top of the scroller to the end of the
+ * buffer, counting no more than max */
+static int count_below(Scroller *s, int max)
+{
+   int i, n = -s->overview;
+
+   for (i=s->cur; i < s->size && n < max; i++)
+      n += line_wraps(s, i);
+   return n < max ? n : max;
 }
 
+/* Screen line shown at the top, for the scrollbar. If it's a long way
+ * past the line starts worked out so far (after jumping to the end of
+ * a big buffer), estimate it, and work out a few more for next time. */
+static int scroller_pos(Scroller *s)
+{
+   if (!s->size) return 0;
+   if (s->cur - s->wrapped > SCRL_LAZY) {
+      line_start(s, s->wrapped + SCRL_LAZY);
+      return (double)s->cur / s->size * s->tlines;
+   }
+   return line_start(s, s->cur) + s->overview;
+}
+
+/* Is there enough lines to scroll down? */
+static bool scroller_can_down(Scroller *s)
+{
+   return count_below(s, s->height-1) > s->height-2;
+}
 
 /* Resize and reposition a scroller window */
 static void scroller_resize(Scroller *s, int height, int width, 
             int starty, int startx)
 {
-   struct scrl_line *l;
-   s->tlines=0;
-   /* Recalculate the number of overflowing lines */
-   for (l=TAILQ_FIRST(&s->buffer); l; l=TAILQ_NEXT(l, entries)) {
-      l->lines = ceil(l->len / (double)(width - 2));
-      s->tlines += l->lines;
-   }
+   int len;
 
-   /* Create a new window */
-   delwin(s->window);
-   s->window = newwin(height, width, starty, startx);
+   /* Move and resize the window */
+   s->window = place_window(s->window, height, width, starty, startx);
    /* Update the size */
    s->height = height;
-   s->width = width;
+   if (width != s->width) {
+      s->width = width;
+      s->cells = trealloc(s->cells, sizeof(chtype) * width);
+      /* Lines of the same length wrap the same, so the total
+       * comes from how many lines there are of each length */
+      s->tlines = 0;
+      for (len=1; len < s->hist_size; len++) {
+         s->tlines += s->hist[len] * ((len + SCRL_TEXTW(s) - 1)
+            / SCRL_TEXTW(s));
+      }
+      s->wrapped = 0;
+   }
+   if (!s->size) return;
+
+   /* Keep the same line at the top */
+   if (s->overview >= line_wraps(s, s->cur))
+      s->overview = line_wraps(s, s->cur) ? line_wraps(s, s->cur) - 1 : 0;
    /* If the windows enlarged, make sure as much as
     * possible is shown */
-   scroller_check_over(s);
+   if (count_below(s, s->height-2) < s->height-2) scroller_bottom(s);
 }
 
 /* Add a line to a Scroller, and update the window accordingly. */
 void scroller_write(Scroller *s, char *msg)
 {
-   struct scrl_line *nline;
-   char *c;
-   int len=0, i=0;
-   bool in_ul=0, in_cyan=0, in_red=0; /* Formatting attributes */
-   
-   s->size++;
-   /* Calculate the length minus formattting chars */
-   for (c=msg; *c; c++) {
-      switch (*c) {
-         case '_':
-         case '{':
-         case '}':
-         case '%':
-            break;
-         default:
-            len++;
-            break;
-      }
+   add_line(s, msg, strlen(msg));
+
+   /* Scroll to bottom and refresh */
+   if (s->rfresh) {
+      scroller_scroll(s, SCROLL_BASE);
+      draw_scroller(s);
    }
+}
 
-   /* Allocate memory */
-   nline = tmalloc(sizeof(*nline));
-   nline->line = tmalloc(len + 1);
-   nline->fmask = tmalloc(sizeof(attr_t) * (len + 1));
+/* Add n characters of text to the end of the buffer as a line, parsing
+ * out the formatting. A newline is shown as a space. */
+static void add_line(Scroller *s, char *msg, long n)
+{
+   struct scrl_line *l = new_line(s);
+   int len = markup_len(msg, n);
+
+   /* Room for the most runs there could be, and give
+    * back what isn't needed */
+   l->text = arena_alloc(s, len + 1 + len * 2);
+   l->runs = l->text + len + 1;
+   l->nruns = markup_parse(msg, n, s->arena + l->text,
+      (unsigned char *)s->arena + l->runs);
+   s->used = l->runs + l->nruns * 2;
+   l->len = len;
+   count_line(s, l);
+}
 
-   /* Parse out formatting characters, and copy over
-    * all other characters with formatting applied */
-   for (c=msg; *c; c++) {
-         switch (*c) {
-            /* _Underlined text_  normal */
-            case '_':
-               in_ul=!in_ul;
-               break;
-               /* { Cyan text } normal */
-            case '{':
-               in_cyan=1;
-               break;
-            case '}':
-               in_cyan=0;
-               break;
-               /* %Red text% normal */
-            case '%':
-               in_red = !in_red;
-               break;
-            default:
-               nline->line[i]=*c;
-               nline->fmask[i]=0;
-               /* Red OR cyan */
-               if (in_cyan) {
-                  nline->fmask[i] |= COLOR_PAIR(C_KEY);
-               } else if (in_red) {
-                  nline->fmask[i] |= COLOR_PAIR(C_URGENT) | A_BOLD;
-               }
-               /* Can be combined with underline */
-               if (in_ul) {
-                  nline->fmask[i] |= A_UNDERLINE;
-               } 
-               i++;
-               break;
-         }
+/* Add an entry to the end of the line table */
+static struct scrl_line *new_line(Scroller *s)
+{
+   struct scrl_line *l;
+
+   if (s->size == s->alloc) {
+      s->alloc *= 2;
+      s->line = trealloc(s->line, sizeof(struct scrl_line) * s->alloc);
    }
-   nline->line[i]='\0';
-   nline->lines = ceil(len / (double)(s->width - 2));
-   s->tlines += nline->lines;
-   nline->len = len;
-   TAILQ_INSERT_TAIL(&s->buffer, nline, entries);
+   l = &s->line[s->size++];
+   l->width = 0;
+   return l;
+}
 
-   if (!s->cur) s->cur=TAILQ_FIRST(&s->buffer);
+/* Count a new line in the total screen lines, and the histogram
+ * of line lengths they're worked out from on a resize */
+static void count_line(Scroller *s, struct scrl_line *l)
+{
+   s->tlines += line_wraps(s, l - s->line);
+   if (l->len >= s->hist_size) {
+      s->hist = trealloc(s->hist, sizeof(int) * (l->len + 1) * 2);
+      memset(s->hist + s->hist_size, 0,
+         sizeof(int) * ((l->len + 1) * 2 - s->hist_size));
+      s->hist_size = (l->len + 1) * 2;
+   }
+   s->hist[l->len]++;
+}
 
-   /* Scroll to bottom and refresh */
-   if (s->rfresh) {
-      scroller_scroll(s, SCROLL_BASE);
-      draw_scroller(s);
+/* Add the lines of a help file that was compiled in. They're already
+ * parsed, so its arena is copied into ours as it is. */
+static void scroller_load(Scroller *s, const struct helpfile *h)
+{
+   struct scrl_line *l;
+   long base = arena_alloc(s, h->size);
+   int i;
+
+   memcpy(s->arena + base, h->arena, h->size);
+   for (i=0; i < h->nlines; i++) {
+      l = new_line(s);
+      l->text = base + h->lines[i].text;
+      l->runs = base + h->lines[i].runs;
+      l->len = h->lines[i].len;
+      l->nruns = h->lines[i].nruns;
+      count_line(s, l);
    }
 }
 
+/* Add the next lines of a mapped file to the buffer, about n bytes
+ * worth (whole lines, so it can be more). Returns 1 if there's more
+ * of the file left, 0 once it's all in. */
+static int scroller_index(Scroller *s, long n)
+{
+   char *p, *nl;
+   long len, stop;
+
+   if (!s->map) return 0;
+   stop = s->map_pos + n;
+   while (s->map_pos < s->map_len && s->map_pos < stop) {
+      p = s->map + s->map_pos;
+      nl = memchr(p, '\n', s->map_len - s->map_pos);
+      len = nl ? nl - p + 1 : s->map_len - s->map_pos;
+      add_line(s, p, len);
+      s->map_pos += len;
+   }
+   return s->map_pos < s->map_len;
+}
+
+/* Index another chunk of the file while waiting for input. The
+ * scrollbar changes as lines are added, so redraw. */
+static int index_idle(void *arg)
+{
+   Scroller *s = arg;
+   int more = scroller_index(s, SCRL_CHUNK);
+   if (s->rfresh) draw_scroller(s);
+   return more;
+}
+
+/* Take n bytes from the end of the arena, growing it if needed.
+ * Returns the offset, as the arena can move. */
+static long arena_alloc(Scroller *s, long n)
+{
+   long off = s->used;
+   if (s->used + n > s->arena_size) {
+      while (s->used + n > s->arena_size) s->arena_size *= 2;
+      s->arena = trealloc(s->arena, s->arena_size);
+   }
+   s->used += n;
+   return off;
+}
 
-/* Scroll a scroller up/down or to the bottom/top */
+/* Scroll a scroller up/down, by a page, or to the bottom/top */
 static void scroller_scroll(Scroller *s, int dir)
 {
+   /* Make sure the lines being scrolled to have been read in */
+   if (dir == SCROLL_BASE) {
+      while (scroller_index(s, SCRL_CHUNK));
+   } else if (dir == SCROLL_DOWN || dir == SCROLL_PAGE_DOWN) {
+      while (count_below(s, s->height * 2) < s->height * 2
+            && scroller_index(s, SCRL_CHUNK));
+   }
+
    /* Buffer is empty */
-   if (!s->cur) return;
+   if (!s->size) return;
 
    switch (dir) {
       case SCROLL_DOWN:
-         if (!scroller_can_down(s)) break;
-         if (s->cur->lines > s->overview+1) {
-            s->overview++;
-         } else {
-            s->cur = TAILQ_NEXT(s->cur, entries);
-            s->overview=0;
-         }
-         s->cur_sl++;
+         scroller_down(s, 1);
          break;
       case SCROLL_UP:
-         if (s->overview>0) {
-            s->overview--;
-            s->cur_sl--;
-         } else if (TAILQ_PREV(s->cur, scrl_hn, entries)) {
-            s->cur = TAILQ_PREV(s->cur, scrl_hn, entries);
-            if (s->cur->lines>1) s->overview = s->cur->lines -1;
-            s->cur_sl--;
-         }
+         scroller_up(s, 1);
+         break;
+      /* Half a screen at a time */
+      case SCROLL_PAGE_DOWN:
+         scroller_down(s, s->height/2);
+         break;
+      case SCROLL_PAGE_UP:
+         scroller_up(s, s->height/2);
          break;
       /* Scroll to the top line */
       case SCROLL_TOP:
-         s->cur = TAILQ_FIRST(&s->buffer);
+         s->cur = 0;
          s->overview=0;
-         s->cur_sl=0;
          break;
       /* Scroll to the bottom line */
       case SCROLL_BASE:
-         {
-            int total=s->height-2;
-            s->cur = TAILQ_LAST(&s->buffer, scrl_hn);
-            s->cur_sl = s->tlines;
-            do {
-               total-=s->cur->lines;
-               s->cur_sl -= s->cur->lines;
-               if (total <= 0) {
-                  s->overview=-total;
-                  return;
-               }
-               if (!TAILQ_PREV(s->cur, scrl_hn, entries)) break;
-            } while ((s->cur=TAILQ_PREV(s->cur, scrl_hn, entries)));
-
-            /* Not enough lines to fill the screen */
-            scroller_scroll(s, SCROLL_TOP);
-         }
+         scroller_bottom(s);
          break;
    }
    if (s->rfresh || s->smooth) draw_scroller(s);
 }
 
+/* Scroll to the bottom, working back from the end. Only the lines
+ * on the screen are looked at. */
+static void scroller_bottom(Scroller *s)
+{
+   int i, n = s->height-2;
+
+   for (i=s->size-1; i >= 0; i--) {
+      if (line_wraps(s, i) >= n) {
+         s->cur = i;
+         s->overview = line_wraps(s, i) - n;
+         return;
+      }
+      n -= line_wraps(s, i);
+   }
+   /* Not enough lines to fill the screen */
+   s->cur = 0;
+   s->overview = 0;
+}
+
+/* Move the top of the scroller down n screen lines, as far as there are
+ * lines to fill the screen. If the start of the top line is known, it's
+ * a jump, otherwise (after jumping to the end, or a resize) only the
+ * lines passed over are looked at. Either way it takes no more than
+ * about n steps, however long the buffer is. */
+static void scroller_down(Scroller *s, int n)
+{
+   int left;
+
+   if (s->cur < s->wrapped) {
+      scroller_jump(s, s->line[s->cur].start + s->overview + n);
+      return;
+   }
+   n = clamp(count_below(s, n + s->height-2) - (s->height-2), 0, n);
+   while (n > 0) {
+      /* Screen lines of this line below the top */
+      left = line_wraps(s, s->cur) - s->overview - 1;
+      if (left >= n) {
+         s->overview += n;
+         break;
+      }
+      if (s->cur + 1 >= s->size) break;
+      n -= left + 1;
+      s->cur++;
+      s->overview = 0;
+   }
+}
+
+/* Move the top of the scroller up n screen lines, the same way */
+static void scroller_up(Scroller *s, int n)
+{
+   if (s->cur < s->wrapped) {
+      scroller_jump(s, s->line[s->cur].start + s->overview - n);
+      return;
+   }
+   while (n > 0 && (s->overview || s->cur > 0)) {
+      if (s->overview >= n) {
+         s->overview -= n;
+         break;
+      }
+      n -= s->overview + 1;
+      s->cur--;
+      s->overview = line_wraps(s, s->cur) - 1;
+      /* Lines with no text take no space */
+      if (s->overview < 0) {
+         s->overview = 0;
+         n++;
+      }
+   }
+}
+
+/* Screen lines covered by the line starts worked out so far */
+static int known_lines(Scroller *s)
+{
+   if (!s->wrapped) return 0;
+   return s->line[s->wrapped-1].start + line_wraps(s, s->wrapped-1);
+}
+
+/* Put screen line sl at the top, or as near as it can go with the screen
+ * still full, with a binary search over the line starts. sl must be no
+ * more than a few screens past the starts known so far, as the ones up
+ * to it are worked out first. */
+static void scroller_jump(Scroller *s, int sl)
+{
+   int lo, hi, mid;
+
+   if (sl >= s->tlines - (s->height-2)) {
+      scroller_bottom(s);
+      return;
+   }
+   if (sl < 0) sl = 0;
+   while (s->wrapped < s->size && known_lines(s) <= sl)
+      line_start(s, s->wrapped);
+
+   /* First line that ends below sl */
+   lo = 0;
+   hi = s->wrapped - 1;
+   while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (s->line[mid].start + line_wraps(s, mid) > sl) hi = mid;
+      else lo = mid + 1;
+   }
+   s->cur = lo;
+   s->overview = sl - s->line[lo].start;
+}
+
+/* Read a search pattern on the bottom border. Returns 0 if it's
+ * cancelled, or left empty. */
+static int scroller_prompt(Scroller *s)
+{
+   char buf[SCRL_SEARCH + 2] = "/";
+   int c, n=1, w;
+
+   for (;;) {
+      buf[n] = '\0';
+      /* Show the end of it, if it doesn't fit */
+      w = s->width - 2;
+      s->msg = n > w ? buf + n - w : buf;
+      draw_scroller(s);
+
+      c = getkey();
+      s->msg = NULL;
+      switch (c) {
+         case KEY_RESIZE:
+            scroller_resize(s, row * 0.9, col * 0.9, row * 0.05, col * 0.05);
+            draw_all();
+            break;
+         case 27: /* Escape */
+         case CTRL('g'):
+            return 0;
+         case 10: /* Enter */
+            if (n == 1) return 0;
+            set_pattern(s, buf + 1);
+            return 1;
+         case KEY_BACKSPACE:
+         case 127:
+         case 8:
+            if (n == 1) return 0;
+            n--;
+            break;
+         default:
+            if (c >= 32 && c < 127 && n <= SCRL_SEARCH) buf[n++] = c;
+            break;
+      }
+   }
+}
+
+/* Use pat as the search pattern, and set up its Horspool table: how far
+ * to shift when the character under the end of the pattern doesn't match */
+static void set_pattern(Scroller *s, char *pat)
+{
+   int i;
+
+   if (s->pat) free(s->pat);
+   s->plen = strlen(pat);
+   s->pat = tmalloc(s->plen + 1);
+   strcpy(s->pat, pat);
+   for (i=0; i < 256; i++) s->skip[i] = s->plen;
+   for (i=0; i < s->plen - 1; i++)
+      s->skip[(unsigned char)pat[i]] = s->plen - 1 - i;
+   s->mline = -1;
+}
+
+/* Column of the first match in a line, at or after from. -1 if none. */
+static int find_text(Scroller *s, struct scrl_line *l, int from)
+{
+   unsigned char *text = (unsigned char *)s->arena + l->text;
+   unsigned char *pat = (unsigned char *)s->pat;
+   int i, j, last = s->plen - 1;
+
+   for (i=from; i + last < l->len; i += s->skip[text[i + last]]) {
+      for (j=last; j >= 0 && text[i + j] == pat[j]; j--);
+      if (j < 0) return i;
+   }
+   return -1;
+}
+
+/* Column of the last match in a line, at or before upto. -1 if none. */
+static int find_last(Scroller *s, struct scrl_line *l, int upto)
+{
+   int m, found=-1;
+
+   for (m=find_text(s, l, 0); m != -1 && m <= upto; m=find_text(s, l, m+1))
+      found = m;
+   return found;
+}
+
+/* Is the last match on the screen? */
+static bool match_shown(Scroller *s)
+{
+   int i, n = -s->overview;
+
+   if (s->mline < s->cur || s->mline >= s->size) return 0;
+   for (i=s->cur; i < s->mline && n < s->height-2; i++)
+      n += line_wraps(s, i);
+   n += s->mcol / SCRL_TEXTW(s);
+   return n >= 0 && n < s->height-2;
+}
+
+/* Scroll to the next (or previous) match, starting from the last one if
+ * it's still on the screen, or else from the top of the screen. Lines of
+ * a file that haven't been read in yet are read as the search gets to
+ * them. Returns 0 if there are no more matches. */
+static int scroller_search(Scroller *s, int back)
+{
+   int i, m, from;
+
+   if (!s->pat) return 0;
+   if (match_shown(s)) {
+      i = s->mline;
+      from = back ? s->mcol - 1 : s->mcol + 1;
+   } else {
+      i = s->cur;
+      from = s->overview * SCRL_TEXTW(s) - back;
+   }
+
+   if (back) {
+      for (; i >= 0; i--, from=INT_MAX) {
+         if (from >= 0 && (m = find_last(s, &s->line[i], from)) != -1)
+            break;
+      }
+      if (i < 0) return 0;
+   } else {
+      for (;; i++, from=0) {
+         if (i >= s->size) scroller_index(s, SCRL_CHUNK);
+         if (i >= s->size) return 0;
+         if ((m = find_text(s, &s->line[i], from)) != -1) break;
+      }
+   }
+
+   /* Put the screen line with the match at the top */
+   s->mline = i;
+   s->mcol = m;
+   s->cur = i;
+   s->overview = m / SCRL_TEXTW(s);
+   if (count_below(s, s->height-2) < s->height-2) scroller_bottom(s);
+   return 1;
+}
+
 
 /* Free memory from a scroller */
 void free_scroller(Scroller *s)
 {
-   while ((s->cur = TAILQ_FIRST(&s->buffer))) {
-      free(s->cur->line);
-      free(s->cur->fmask);
-      TAILQ_REMOVE(&s->buffer, s->cur, entries);
-      free(s->cur);
-   }
+   free(s->line);
+   free(s->arena);
+   free(s->hist);
+   if (s->map) munmap(s->map, s->map_len);
+   if (s->pat) free(s->pat);
+   free(s->cells);
    if (s->title) free(s->title);
    delwin(s->window);
    free(s);
 }
 
 
-/* Load a text file into a scroller dialog */
+/* Show one of the help files compiled into nsuds in a scroller dialog.
+ * It can't change, so the scroller is kept for next time. */
+void launch_help(char *name, char *title)
+{
+   static Scroller *s;
+   static const struct helpfile *shown;
+   const struct helpfile *h;
+
+   for (h=helpfiles; h->name; h++) {
+      if (!strcmp(h->name, name)) break;
+   }
+   if (s && h == shown) {
+      scroller_reopen(s);
+   } else {
+      if (s) free_scroller(s);
+      s = scroller_new(row * 0.9, col * 0.9, row * 0.05, col * 0.05, title);
+      scroller_set(s, SCRL_RFRESH, 0);
+      if (h->name) scroller_load(s, h);
+      else scroller_write(s, "Error: No such help file");
+      shown = h;
+   }
+   scroller_set(s, SCRL_RFRESH, 1);
+
+   /* Place over everything */
+   overwrite(s->window, board.win);
+   scroller_input_loop(s);
+}
+
+/* Write an error about the file being shown, and why, to a scroller.
+ * The name isn't shown, as it could be taken for formatting. */
+static void file_error(Scroller *s, char *what)
+{
+   char *why = strerror(errno);
+   char *msg = tmalloc(strlen(what) + strlen(why) + 32);
+
+   sprintf(msg, "Error: %s the file (%s)", what, why);
+   scroller_write(s, msg);
+   free(msg);
+}
+
+/* Show a text file in a scroller dialog. The file is mapped in, and
+ * only the first screen is read before it's drawn; the rest of the lines
+ * are indexed between keypresses. */
 void launch_file(char *fname, char *title)
 {
-   FILE *fd;
    Scroller *s;
+   struct stat f;
+   void *map;
+   int fd;
 
    s = scroller_new(row * 0.9, col * 0.9, row * 0.05, col * 0.05, title);
 
    /* Don't draw until we're done adding lines */
    scroller_set(s, SCRL_RFRESH, 0);
    
-   /* Read in the file */
-   fd=fopen(fname, "r");
-   if (fd==NULL) {
-      /* Perhaps they're not installed properly */
-      scroller_write(s, "Error: Can't access help files!");
-      scroller_write(s, "Are you sure they are installed correctly?");
+   fd = open(fname, O_RDONLY);
+   if (fd == -1) {
+      file_error(s, "Can't open");
    } else {
-      struct stat f;
-      if (stat(fname, &f) == -1) 
-         scroller_write(s, "Error: Can't stat helpfile");
+      if (fstat(fd, &f) == -1) 
+         file_error(s, "Can't stat");
       else if (f.st_size == 0) 
-         scroller_write(s, "Error: Help file empty");
+         scroller_write(s, "There's nothing in this file yet");
       else {
-         char *buffer;
-         buffer=tmalloc(4096);
-
-         /* Get each line, max 4096 chars */
-         while (fgets(buffer, 4096, fd)) {
-            char *m = (char *)memchr(buffer, '\n', 4096);
-            *m=' ';
-            scroller_write(s, buffer);
+         map = mmap(NULL, f.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (map == MAP_FAILED) {
+            file_error(s, "Can't read");
+         } else {
+            s->map = map;
+            s->map_len = f.st_size;
          }
-         free(buffer);
       }
-      fclose(fd);
+      /* The mapping stays after it's closed */
+      close(fd);
    }
 
+   /* Read enough for the first screen, and the rest in the background */
+   if (scroller_index(s, SCRL_CHUNK)) frame_idle(index_idle, s);
+
    /* Allow draws again (and draw) */
    scroller_set(s, SCRL_RFRESH, 1);
 
    /* Place over everything */
-   overwrite(s->window, grid);
+   overwrite(s->window, board.win);
 
    /* Handle user input */
    scroller_input_loop(s);
 
    /* User has closed the scroller, free it */
+   frame_idle(NULL, NULL);
    free_scroller(s);
 }
 
+/* Get a scroller that was kept after it was closed ready to be shown
+ * again: fit it to the screen, which may have been resized since, and
+ * go back to the top. Nothing is drawn until SCRL_RFRESH is set. */
+void scroller_reopen(Scroller *s)
+{
+   s->rfresh = 0;
+   s->msg = NULL;
+   scroller_resize(s, row * 0.9, col * 0.9, row * 0.05, col * 0.05);
+   scroller_scroll(s, SCROLL_TOP);
+}
+
 /* Handle input on a scroller, so user can scroll and then close it. Handles
  * window resizes */
 void scroller_input_loop(Scroller *s)
 {
-   int c, i;
+   int c;
    /* Handle input */
    while ((c=getkey())) {
+      if (s->msg) {
+         s->msg = NULL;
+         draw_scroller(s);
+      }
       switch (c) {
          case KEY_RESIZE:
-            getmaxyx(stdscr, row, col);
             scroller_resize(s, row * 0.9, col * 0.9, row * 0.05, col * 0.05);
             draw_all();
             draw_scroller(s);
@@ -424,16 +862,12 @@ void scroller_input_loop(Scroller *s)
          case KEY_PPAGE:
          case CTRL('u'):
          case ALT('v'):
-            scroller_set(s, SCRL_RFRESH, 0);
-            for (i=0;i<(s->height/2);i++) scroller_scroll(s, SCROLL_UP);
-            scroller_set(s, SCRL_RFRESH, 1);
+            scroller_scroll(s, SCROLL_PAGE_UP);
             break;
          case KEY_NPAGE:
          case CTRL('d'):
          case CTRL('v'):
-            scroller_set(s, SCRL_RFRESH, 0);
-            for (i=0;i<(s->height/2);i++) scroller_scroll(s, SCROLL_DOWN);
-            scroller_set(s, SCRL_RFRESH, 1);
+            scroller_scroll(s, SCROLL_PAGE_DOWN);
             break;
          case KEY_HOME:
          case 'g':
@@ -445,6 +879,20 @@ void scroller_input_loop(Scroller *s)
             scroller_scroll(s, SCROLL_BASE);
             draw_scroller(s);
             break;
+         /* Search forward, or back, like less */
+         case '/':
+            if (!scroller_prompt(s)) {
+               draw_scroller(s);
+               break;
+            }
+            /* Fall through */
+         case 'n':
+         case 'N':
+            if (!s->pat) s->msg = " No search pattern (press /) ";
+            else if (!scroller_search(s, c == 'N'))
+               s->msg = " Pattern not found ";
+            draw_scroller(s);
+            break;
          case 'Q':
          case 'q':
          case 27: /* Escape */
@@ -19,17 +19,31 @@
  */
 #ifndef _NSUDS_SCROLLER_H
 #define _NSUDS_SCROLLER_H
-#include <sys/queue.h>
 
-enum {SCROLL_UP, SCROLL_DOWN, SCROLL_TOP, SCROLL_BASE};
+enum {SCROLL_UP, SCROLL_DOWN, SCROLL_PAGE_UP, SCROLL_PAGE_DOWN,
+      SCROLL_TOP, SCROLL_BASE};
 enum {SCRL_RFRESH};
 
+#define SCRL_ARENA 4096 /* Starting size of the arena */
+#define SCRL_LINES 64   /* Starting size of the line table */
+#define SCRL_HIST  256  /* Starting size of the line length histogram */
+#define SCRL_LAZY  1024 /* Most line starts worked out for one draw */
+#define SCRL_CHUNK 65536 /* Bytes of a file indexed at a time */
+#define SCRL_SEARCH 64  /* Longest search pattern */
+
+/* Width of text in a scroller, inside the border */
+#define SCRL_TEXTW(s) ((s)->width > 2 ? (s)->width - 2 : 1)
+
+/* A line of text. The text and its format runs are kept in the
+ * scroller's arena; a run is a flags byte followed by a length byte. */
 struct scrl_line {
-   char *line;    /* Text of the line */
-   attr_t *fmask; /* Format mask */
-   int lines;     /* Number of screen lines each line will take up */
-   short len;     /* Length of line */
-   TAILQ_ENTRY(scrl_line) entries;
+   long text;     /* Offset of the text in the arena */
+   long runs;     /* Offset of the format runs */
+   int len;       /* Length of line */
+   int nruns;     /* Number of format runs */
+   int lines;     /* Number of screen lines the line takes up, */
+   int width;     /* when the scroller is this wide */
+   int start;     /* Screen line it starts on (the lines before it, summed) */
 };
 
 /* Scrolling window */
@@ -43,17 +57,34 @@ typedef struct {
    int size;		         /* # of lines in buffer (pos) */
    int tlines;             /* Total screen lines */
    int overview;           /* Overflow offset for this->cur */
-   int cur_sl;             /* Current screen line shown */
-   struct scrl_line *cur;  /* First line shown in the scroller */
-   TAILQ_HEAD(scrl_hn, scrl_line) buffer; /* List of lines */
+   int cur;                /* First line shown in the scroller */
+   struct scrl_line *line; /* Table of lines */
+   int alloc;              /* Lines allocated in the table */
+   int wrapped;            /* Lines whose start is known at this width */
+   int *hist;              /* Number of lines of each length */
+   int hist_size;
+   char *arena;            /* Text and format runs of every line */
+   long used;              /* Bytes used in the arena */
+   long arena_size;        /* and allocated */
+   char *map;              /* File being viewed, mapped in */
+   long map_len;
+   long map_pos;           /* How much of it is in the buffer */
+   char *pat;              /* Search pattern, or NULL */
+   int plen;
+   int skip[256];          /* Horspool shift for each last character */
+   int mline, mcol;        /* Last match found, mline is -1 if none */
+   char *msg;              /* Shown on the bottom border until a key */
+   chtype *cells;          /* A screen line, ready to draw in one go */
 } Scroller;
 
 extern void launch_file(char *fname, char *title);
+extern void launch_help(char *name, char *title);
 extern Scroller *scroller_new(int height, int width, int starty, 
                 int startx, char *title);
 extern void scroller_set(Scroller *s, int flag, int val);
 extern void scroller_write(Scroller *s, char *msg);
 extern void scroller_input_loop(Scroller *s);
+extern void scroller_reopen(Scroller *s);
 extern void free_scroller(Scroller *s);
 
 #endif
@@ -17,23 +17,22 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
  */
-#define _XOPEN_SOURCE
+#define _XOPEN_SOURCE 500
 
 #include <stdio.h>
 #include <unistd.h>
-#include <signal.h>
+#include <time.h>
 #ifdef HAVE_NCURSES_H
    #include <ncurses.h>
 #else 
    #include <curses.h>
 #endif
-#include <errno.h>
-#include <err.h>
 
 #include "nsuds.h"
 #include "timer.h"
-#include "grid.h"
+#include "frame.h"
 #include "util.h"
+#include "save.h"
 
 
 /* "Font" for numbers taken from htop, by Hisham Muhammad */
@@ -46,115 +45,261 @@ static char *empty="   ";
 struct ltimer cdown, ltime={0,0};
 struct gtimer gtime={0,0, 0};
 
+/* The clock is milliseconds of CLOCK_MONOTONIC, so it never jumps
+ * when the date is changed. The level and game times only count time
+ * spent playing; cdown, ltime and gtime are worked out from them. */
+#ifndef CLOCK_MONOTONIC
+   #define CLOCK_MONOTONIC CLOCK_REALTIME
+#endif
+
+static long limit_ms;  /* Time given for the level */
+static long level_ms;  /* Time played on this level */
+static long game_ms;   /* Time played in the whole game */
+static long synced;    /* Clock when the times were last brought up to date */
+static long next_tick; /* Clock when the timer is next due */
+static int stopped=1;  /* Game is paused, so the times don't count */
+static int idle=0;     /* Nothing to tick for, until the next sync */
+static int frozen=0;   /* Never tick? */
+
+static void sync_timer(void);
+static long skip_secs(void);
+
 /* Start a new timer for a level,
  * cancels any old timers */
 void start_timer(int mins, int secs)
 {
-   struct sigaction new;
-
-   /* Setup countdown */
-   cdown.mins = mins;
-   cdown.secs = secs;
-   /* Reset level timer */
-   ltime.mins = ltime.secs = 0;
-
-   /* Set up signal handler */
-   new.sa_handler = catch_alarm;
-   sigemptyset(&new.sa_mask);
-   new.sa_flags = 0;
-   
-#ifdef SA_RESTART
-   /* Restart interrupted system calls */
-   new.sa_flags |= SA_RESTART;
-#endif
-   
-   if (sigaction(SIGALRM, &new, NULL) < 0)
-      err(errno, "Can't set up signal handler");
+   limit_ms = (mins * 60L + secs) * 1000;
+   level_ms = 0;
+   sync_timer();
 
    /* Update timer */
    draw_timer();
-   alarm(1);
 }
 
-/* Called every second when in game (unless paused).
- * Update game timers, and handle the fbar timeout */
-void catch_alarm(unused int sig)
+/* Carry on with the times loaded into cdown, ltime and gtime
+ * from a saved game */
+void resume_timer(void)
 {
-   alarm(1);
+   level_ms = (ltime.mins * 60L + ltime.secs) * 1000;
+   limit_ms = (cdown.mins * 60L + cdown.secs) * 1000 + level_ms;
+   game_ms = ((gtime.hours * 60L + gtime.mins) * 60 + gtime.secs) * 1000;
+   sync_timer();
+   draw_timer();
+}
 
-   /* If function bar is shown, countdown it's timer
-    * and erase when it expires */
-   if (fbar_time && !(--fbar_time)) {
-      hide_fbar();
-   }
+/* Start counting the total game time again from 0 */
+void reset_game_timer(void)
+{
+   sync_timer();
+   game_ms = 0;
+   sync_timer();
+}
 
-   /* Don't countdown if paused */
-   if (is_paused()) return;
+/* Stop (or start) the times counting, when the game is paused */
+void timer_pause(int stop)
+{
+   /* There's nothing to time until a game has started */
+   if (!stop && !is_playing()) return;
+   sync_timer();
+   stopped = stop;
+   sync_timer();
+}
 
-   /* Decrement level timer */
-   if (cdown.secs > 0) {
-      cdown.secs--;
-   } else {
-      cdown.mins--;
-      cdown.secs=59;
-   }
+/* Milliseconds played on the level, and left to play */
+long timer_played(void)
+{
+   sync_timer();
+   return level_ms;
+}
+
+long timer_left(void)
+{
+   sync_timer();
+   return level_ms < limit_ms ? limit_ms - level_ms : 0;
+}
+
+/* Stop the timer ticking at all (for the benchmark) */
+void timer_freeze(void)
+{
+   sync_timer();
+   frozen=1;
+}
 
-   /* Increment level time */
-   if (ltime.secs < 59) {
-      ltime.secs++;
+/* Milliseconds until the timer is due, for poll().
+ * 0 if it's due now, -1 if it never will be. While the game is paused,
+ * it's only due for the fbar and autosave, so an idle game sleeps. */
+int timer_wait(void)
+{
+   long now, ms=-1, save;
+
+   if (frozen) return -1;
+   now = clock_ms();
+   if (stopped && !fbar_time) {
+      idle=1;
    } else {
-      ltime.mins++;
-      ltime.secs=0;
+      /* Count the fbar down from when it was shown */
+      if (idle || (fbar_time && next_tick - now > 1000))
+         next_tick = now + 1000;
+      idle=0;
+      ms = next_tick > now ? next_tick - now : 0;
    }
 
-   /* Increment total game time */
-   if (gtime.secs < 59) {
-      gtime.secs++;
-   } else if (gtime.mins < 59) {
-      gtime.mins++;
-      gtime.secs=0;
-   } else {
-      gtime.mins = gtime.secs = 0;
-      gtime.hours++;
+   save = autosave_wait();
+   if (save >= 0 && (ms < 0 || save < ms)) ms = save;
+   return ms;
+}
+
+/* Called from the event loop when timer_wait() says it's due: as each
+ * second of play is up, or every second while the fbar is shown.
+ * Update game timers, and handle the fbar timeout */
+void timer_tick(void)
+{
+   /* Write out any autosave records that have waited long enough */
+   autosave_tick();
+   if (idle || clock_ms() < next_tick) return;
+
+   sync_timer();
+
+   /* If function bar is shown, countdown it's timer
+    * and erase when it expires */
+   if (fbar_time && !(--fbar_time)) {
+      frame_dirty(FRAME_FBAR);
    }
 
+   /* Don't countdown if paused */
+   if (stopped) return;
+
    /* If timer reaches 0 */
-   if (!cdown.secs && !cdown.mins) {
-      alarm(0);
+   if (level_ms >= limit_ms) {
       game_over();
       return;
    }
 
-   draw_timer();
-   draw_stats();
-   movec(CUR);
-   doupdate();
+   /* On a slow link, only show the time every so often */
+   if (!low_bandwidth || !(cdown.secs % low_bandwidth))
+      frame_dirty(FRAME_TIMER | FRAME_STATS);
 }
 
 
-/* Get each line of timer digits in ascii font */
-#define time2strs(line) t2s(line-1, cdown.mins, cdown.secs)
-/* Shorthand */
-#define TD timer_digits
-/* If time < 10 mins, first 0 digit isn't shown */
-#define FTD(l, m) m>=10 ? TD[l][m/10] : empty
-/* t2s(line, mins, seconds): Get ascii strings from time */
-#define t2s(l,m,s) FTD(l, m), TD[l][m%10], TD[l][s/10], TD[l][s%10]
+/* Glyph shown in each of the 4 places (mm:ss), -1 for none */
+static int shown[4];
+static int shown_left=-1; /* Column the time starts at */
+
+static void timer_layout(int g[4], int x[4], int *left);
+static void draw_glyph(int g, int x);
 
 /* Draw timer window, with updated timers */
 void draw_timer()
 {
-   int left;
+   int g[4], x[4], left, i;
    werase(timer);
 
-   if (cdown.mins > 19) left = 2;
-   else left = 1;
    box(timer, 0, 0);
    mvwaddstr(timer, 1, 5, "Time Remaining");
-   mvwprintw(timer, 2, left, "%s%s   %s%s", time2strs(1));
-   mvwprintw(timer, 3, left, "%s%s . %s%s", time2strs(2));
-   mvwprintw(timer, 4, left, "%s%s . %s%s", time2strs(3));
+   timer_layout(g, x, &left);
+   for (i=0; i<4; i++) {
+      draw_glyph(g[i], x[i]);
+      shown[i] = g[i];
+   }
+   shown_left = left;
+   mvwaddstr(timer, 3, x[1] + 4, " . ");
+   mvwaddstr(timer, 4, x[1] + 4, " . ");
+
+   frame_refresh(timer);
+}
+
+/* Bring the timer up to date, only redrawing the digits that have
+ * changed. Usually that's just the last one. */
+void update_timer(void)
+{
+   int g[4], x[4], left, i, changed=0;
+
+   timer_layout(g, x, &left);
+   /* Everything moves if the time changes width */
+   if (left != shown_left || (g[0] < 0) != (shown[0] < 0)) {
+      draw_timer();
+      return;
+   }
+   for (i=0; i<4; i++) {
+      if (g[i] == shown[i]) continue;
+      draw_glyph(g[i], x[i]);
+      shown[i] = g[i];
+      changed=1;
+   }
+   if (changed) frame_refresh(timer);
+}
+
+/* Work out the glyph and column of each place in the time left */
+static void timer_layout(int g[4], int x[4], int *left)
+{
+   /* If time < 10 mins, first 0 digit isn't shown */
+   g[0] = cdown.mins >= 10 ? cdown.mins / 10 : -1;
+   g[1] = cdown.mins % 10;
+   g[2] = cdown.secs / 10;
+   g[3] = cdown.secs % 10;
+
+   *left = cdown.mins > 19 ? 2 : 1;
+   x[0] = *left;
+   x[1] = x[0] + (g[0] < 0 ? 3 : 4); /* empty is narrower */
+   x[2] = x[1] + 4 + 3; /* Past the " . " */
+   x[3] = x[2] + 4;
+}
+
+/* Draw the 3 lines of a digit in the htop font, or blanks if g < 0 */
+static void draw_glyph(int g, int x)
+{
+   int l;
+   for (l=0; l<3; l++)
+      mvwaddstr(timer, 2 + l, x, g < 0 ? empty : timer_digits[l][g]);
+}
+
+/* Add on the time played since the last sync, work out the times
+ * shown from it, and when the timer is next due */
+static void sync_timer(void)
+{
+   long now = clock_ms(), s;
+
+   if (!stopped && !frozen) {
+      level_ms += now - synced;
+      game_ms += now - synced;
+   }
+   synced = now;
+
+   /* Time left is rounded up, so it shows 0:00 as it runs out */
+   s = (level_ms < limit_ms ? limit_ms - level_ms + 999 : 0) / 1000;
+   cdown.mins = s / 60;
+   cdown.secs = s % 60;
+   s = level_ms / 1000;
+   ltime.mins = s / 60;
+   ltime.secs = s % 60;
+   s = game_ms / 1000;
+   gtime.hours = s / 3600;
+   gtime.mins = s / 60 % 60;
+   gtime.secs = s % 60;
 
-   wnoutrefresh(timer);
+   if (stopped) next_tick = now + 1000;
+   else next_tick = now + 1000 - level_ms % 1000 + (skip_secs() - 1) * 1000;
+   idle=0;
 }
 
+/* Seconds of play until the timer next has something to do. On a
+ * slow link, that's when the time is next shown, or it runs out. */
+static long skip_secs(void)
+{
+   long left = cdown.mins * 60L + cdown.secs, k;
+
+   if (!low_bandwidth || fbar_time) return 1;
+   for (k=1; left - k > 0 && (left - k) % 60 % low_bandwidth; k++);
+   return k;
+}
+
+/* Milliseconds since the clock was first read */
+long clock_ms(void)
+{
+   static time_t base;
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   if (!base) base = ts.tv_sec;
+   return (ts.tv_sec - base) * 1000L + ts.tv_nsec / 1000000;
+}
@@ -35,8 +35,17 @@ struct gtimer {
 };
 
 extern void draw_timer();
-extern void catch_alarm(int sig);
+extern void update_timer(void);
 extern void start_timer(int mins, int secs);
+extern void resume_timer(void);
+extern void reset_game_timer(void);
+extern void timer_pause(int stop);
+extern long timer_played(void);
+extern long timer_left(void);
+extern long clock_ms(void);
+extern void timer_freeze(void);
+extern int timer_wait(void);
+extern void timer_tick(void);
 extern struct ltimer cdown, ltime;
 extern struct gtimer gtime;
 
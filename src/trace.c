@@ -0,0 +1,210 @@
+/* nsuds - The ncurses sudoku program
+ * Text-graphical sudoku with pencil-marking support.
+ * Copyright (C) 2009, 2010 Vincent Launchbury.
+ * -------------------------------------------
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  US
+ */
+
+/* trace.c
+ * -------
+ * --trace-render: measure what drawing costs. Curses output is sent
+ * through a pipe that we relay to the terminal, so every byte written
+ * can be counted. ncurses falls back to stderr for the terminal's
+ * settings and size when stdout isn't a tty, so everything else works
+ * as normal. For each frame, we count the windows refreshed, the
+ * screen cells that changed and the bytes it took, and a summary is
+ * written to a log when nsuds exits. */
+#include "config.h"
+
+#define _GNU_SOURCE /* For F_SETPIPE_SZ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#ifdef HAVE_NCURSES_H
+   #include <ncurses.h>
+#else
+   #include <curses.h>
+#endif
+
+#include "frame.h"
+#include "trace.h"
+
+/* Totals for each kind of frame */
+static struct {
+   char *name;
+   long frames;
+   long refreshes; /* Windows refreshed (wnoutrefresh) */
+   long cells;     /* Screen cells that changed */
+   long bytes;     /* Bytes written to the terminal */
+   long max_bytes; /* Most bytes in one frame */
+} kinds[TRACE_KINDS] = {
+   {"input", 0, 0, 0, 0, 0},
+   {"timer", 0, 0, 0, 0, 0},
+   {"redraw", 0, 0, 0, 0, 0}
+};
+
+static int tracing=0;
+static char *log_name;
+static int relay_fd=-1; /* Read end of the pipe curses writes to */
+static int tty_fd=-1;   /* The real terminal */
+static time_t started;
+
+static long refreshes=0; /* Since the last frame */
+static int redrawn=0;    /* draw_all() since the last frame? */
+static int kind;
+static long cells;
+static long bytes=0;     /* Relayed since the last frame */
+
+static void trace_finish(void);
+
+/* Start tracing, writing the summary to log. Must be called before
+ * curses is started. Returns 0 if tracing couldn't be set up. */
+int trace_init(char *log)
+{
+   int p[2];
+
+   if (!isatty(STDOUT_FILENO) || !isatty(STDERR_FILENO)) return 0;
+   if (pipe(p) == -1) return 0;
+#ifdef F_SETPIPE_SZ
+   /* A frame bigger than the pipe would block curses forever */
+   fcntl(p[1], F_SETPIPE_SZ, 1024 * 1024);
+#endif
+   fcntl(p[0], F_SETFL, O_NONBLOCK);
+
+   tty_fd = dup(STDOUT_FILENO);
+   dup2(p[1], STDOUT_FILENO);
+   close(p[1]);
+   relay_fd = p[0];
+
+   log_name = log;
+   started = time(NULL);
+   tracing=1;
+   atexit(trace_finish);
+   return 1;
+}
+
+/* A window was refreshed */
+void trace_refresh(void)
+{
+   refreshes++;
+}
+
+/* The whole screen was redrawn, with draw_all() */
+void trace_redraw(void)
+{
+   redrawn=1;
+}
+
+/* Called just before doupdate(), to count the cells it will change */
+void trace_frame_start(int regions)
+{
+   int y, x, ny, nx, cy, cx;
+
+   if (!tracing) return;
+
+   if (redrawn) kind = TRACE_REDRAW;
+   else if (regions & FRAME_TIMER) kind = TRACE_TIMER;
+   else kind = TRACE_INPUT;
+
+   /* Moving the cursor of curscr would confuse curses
+    * about where the real cursor is, so put it back */
+   getyx(newscr, ny, nx);
+   getyx(curscr, cy, cx);
+   cells=0;
+   for (y=0; y<LINES; y++) {
+      if (!is_linetouched(newscr, y)) continue;
+      for (x=0; x<COLS; x++) {
+         if (mvwinch(newscr, y, x) != mvwinch(curscr, y, x)) cells++;
+      }
+   }
+   wmove(newscr, ny, nx);
+   wmove(curscr, cy, cx);
+}
+
+/* Called just after doupdate(), to count what it wrote */
+void trace_frame_end(void)
+{
+   if (!tracing) return;
+
+   trace_relay();
+   if (!cells && !bytes) {
+      refreshes=0;
+      return;
+   }
+   kinds[kind].frames++;
+   kinds[kind].refreshes += refreshes;
+   kinds[kind].cells += cells;
+   kinds[kind].bytes += bytes;
+   if (bytes > kinds[kind].max_bytes) kinds[kind].max_bytes = bytes;
+   refreshes=0;
+   redrawn=0;
+   bytes=0;
+}
+
+/* Pass on everything curses has written to the terminal.
+ * Only uses async-signal-safe calls. */
+void trace_relay(void)
+{
+   char buf[4096];
+   ssize_t n, w, off;
+
+   if (!tracing) return;
+   while ((n = read(relay_fd, buf, sizeof(buf))) > 0) {
+      bytes += n;
+      for (off=0; off < n; off += w) {
+         w = write(tty_fd, buf + off, n - off);
+         if (w < 0 && errno != EINTR) return;
+         if (w < 0) w = 0;
+      }
+   }
+}
+
+/* At exit: pass on the last of the output, and write the summary */
+static void trace_finish(void)
+{
+   FILE *fd;
+   long secs, frames=0, total=0;
+   int i;
+
+   trace_relay();
+   kinds[TRACE_INPUT].bytes += bytes; /* e.g. from endwin() */
+
+   fd = fopen(log_name, "w");
+   if (fd == NULL) return;
+
+   secs = time(NULL) - started;
+   fprintf(fd, "nsuds render trace, %ld seconds, %dx%d\n\n", secs, COLS,
+      LINES);
+   fprintf(fd, "%-8s %7s %9s %9s %10s %9s %9s\n", "frames", "count",
+      "refreshes", "cells", "bytes", "bytes/frm", "max bytes");
+   for (i=0; i<TRACE_KINDS; i++) {
+      fprintf(fd, "%-8s %7ld %9ld %9ld %10ld %9ld %9ld\n", kinds[i].name,
+         kinds[i].frames, kinds[i].refreshes, kinds[i].cells,
+         kinds[i].bytes,
+         kinds[i].frames ? kinds[i].bytes / kinds[i].frames : 0,
+         kinds[i].max_bytes);
+      frames += kinds[i].frames;
+      total += kinds[i].bytes;
+   }
+   fprintf(fd, "\n%ld frames, %ld bytes", frames, total);
+   if (secs) fprintf(fd, ", %ld bytes/minute", total * 60 / secs);
+   fputc('\n', fd);
+   fclose(fd);
+}
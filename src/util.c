@@ -59,3 +59,34 @@ void *trealloc(void *p, size_t n)
    return p;
 }
 
+
+/* Give a window a new size and position, reusing win where possible
+ * instead of making a new window. win may be NULL, to make one. If
+ * the terminal is too small, the window is cut down to fit. If none of
+ * it would be on the screen, it's moved on, so there's always a window
+ * (of at least 1x1) for the caller to draw in. */
+WINDOW *place_window(WINDOW *win, int height, int width,
+            int starty, int startx)
+{
+   int y, x, h, w;
+
+   starty = clamp(starty, 0, LINES - 1);
+   startx = clamp(startx, 0, COLS - 1);
+   height = clamp(height, 1, LINES - starty);
+   width = clamp(width, 1, COLS - startx);
+   if (!win) return newwin(height, width, starty, startx);
+
+   getbegyx(win, y, x);
+   getmaxyx(win, h, w);
+   if (y == starty && x == startx && h == height && w == width) return win;
+
+   /* Shrink, then move, then grow, so the window
+    * never hangs off the edge of the screen */
+   if (wresize(win, height < h ? height : h, width < w ? width : w) == ERR
+         || mvwin(win, starty, startx) == ERR
+         || wresize(win, height, width) == ERR) {
+      delwin(win);
+      win = newwin(height, width, starty, startx);
+   }
+   return win;
+}
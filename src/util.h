@@ -22,6 +22,8 @@
 
 extern void *tmalloc(size_t n);
 extern void *trealloc(void *p, size_t n);
+extern WINDOW *place_window(WINDOW *win, int height, int width,
+            int starty, int startx);
 
 #define clamp(x,low,high) (((x)>(high)) ? (high) : (((x)<(low)) ? (low) : (x)))
 